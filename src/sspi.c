@@ -25,7 +25,7 @@
 
 #include "sspi.h"
 
-uint8_t sspi_byte_read_write(struct sspi const *bus, uint8_t write_byte)
+SSPI_HOT uint8_t sspi_byte_read_write(struct sspi const *bus, uint8_t write_byte)
 {
     int const word_size = (bus->word_size && bus->word_size < 8) ? bus->word_size : 8;
     uint8_t const word_msb_mask = 1 << (word_size - 1);
@@ -56,15 +56,191 @@ uint8_t sspi_byte_read_write(struct sspi const *bus, uint8_t write_byte)
     return read_byte;
 }
 
-void sspi_read_write(struct sspi const *bus,
+SSPI_HOT uint8_t sspi_dtr_byte_read_write(struct sspi const *bus, uint8_t write_byte)
+{
+    sspi_pin_state_t const sck_lead = bus->cpol_1 ? SSPI_PIN_LOW : SSPI_PIN_HIGH;
+    sspi_pin_state_t const sck_trail = bus->cpol_1 ? SSPI_PIN_HIGH : SSPI_PIN_LOW;
+    uint8_t read_byte = 0;
+
+    for (int bit = 0; bit < 8; bit++)
+    {
+        uint8_t const mask = bus->lsb ? (uint8_t)(0x01 << bit) : (uint8_t)(0x80 >> bit);
+
+        /* Even bits go on the leading edge, odd bits on the trailing edge */
+        bus->write_mosi(bus, (write_byte & mask) ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+        bus->delay(bus);
+        bus->write_sck(bus, (bit & 1) ? sck_trail : sck_lead);
+        if (sspi_miso_read(bus) == SSPI_PIN_HIGH) { read_byte |= mask; }
+    }
+
+    return read_byte;
+}
+
+bool sspi_wait_ready(struct sspi const *bus)
+{
+    if (!bus->is_ready) { return true; }
+
+    for (unsigned long time = 0; !bus->is_ready(bus); time++)
+    {
+        if (bus->ready_timeout && time >= bus->ready_timeout) { return false; }
+        bus->delay(bus);
+    }
+
+    return true;
+}
+
+/* Framing between two words */
+static void word_gap(struct sspi const *bus)
+{
+    unsigned gap = bus->word_gap;
+
+    if (bus->cs_per_word)
+    {
+        /* Hold CS for a half period after the last edge */
+        bus->delay(bus);
+        sspi_select(bus, false);
+        if (!gap) { gap = 1; }
+    }
+
+    while (gap--) { bus->delay(bus); }
+
+    if (bus->cs_per_word) { sspi_select(bus, true); }
+}
+
+/* Word loop with framing and handshake shared by the single and double data rate operations */
+SSPI_HOT static bool read_write(struct sspi const *bus,
+                                uint8_t *read_buff,
+                                uint8_t const *write_buff,
+                                size_t size,
+                                uint8_t (*byte_read_write)(struct sspi const *bus, uint8_t write_byte))
+{
+    sspi_ready_policy_t const policy = bus->is_ready ? bus->ready_policy : SSPI_READY_NONE;
+    size_t const interval = (policy == SSPI_READY_WORDS && bus->ready_interval) ? bus->ready_interval : 1;
+    size_t countdown = 0;
+    bool done = true;
+
+    if (!size) { return true; }
+    if (policy == SSPI_READY_TRANSACTION && !sspi_wait_ready(bus)) { return false; }
+    if (bus->cs_per_word) { sspi_select(bus, true); }
+
+    for (size_t word = 0; word < size; word++)
+    {
+        if (word) { word_gap(bus); }
+
+        if (policy == SSPI_READY_WORDS && !countdown--)
+        {
+            done = sspi_wait_ready(bus);
+            if (!done) { break; }
+            countdown = interval - 1;
+        }
+
+        uint8_t const tx_byte = write_buff ? *write_buff++ : 0x00;
+        uint8_t const rx_byte = byte_read_write(bus, tx_byte);
+        if (read_buff) { *read_buff++ = rx_byte; }
+    }
+
+    if (bus->cs_per_word)
+    {
+        bus->delay(bus);
+        sspi_select(bus, false);
+    }
+
+    return done;
+}
+
+bool sspi_read_write(struct sspi const *bus,
                      uint8_t *read_buff,
                      uint8_t const *write_buff,
                      size_t size)
 {
-    while (size--)
+    return read_write(bus, read_buff, write_buff, size, sspi_byte_read_write);
+}
+
+bool sspi_dtr_read_write(struct sspi const *bus,
+                         uint8_t *read_buff,
+                         uint8_t const *write_buff,
+                         size_t size)
+{
+    return read_write(bus, read_buff, write_buff, size, sspi_dtr_byte_read_write);
+}
+
+bool sspi_transfer(struct sspi const *bus, struct sspi_transfer const *xfer)
+{
+    bool done = true;
+
+    if (!bus->cs_per_word) { sspi_select(bus, true); }
+    for (; done && xfer; xfer = xfer->next)
     {
-        uint8_t const tx_byte = write_buff ? *write_buff++ : 0x00;
-        uint8_t const rx_byte = sspi_byte_read_write(bus, tx_byte);
-        if (read_buff) { *read_buff++ = rx_byte; }
+        done = xfer->dtr ? sspi_dtr_read_write(bus, xfer->read_buff, xfer->write_buff, xfer->size) :
+                           sspi_read_write(bus, xfer->read_buff, xfer->write_buff, xfer->size);
+    }
+    if (!bus->cs_per_word) { sspi_select(bus, false); }
+
+    return done;
+}
+
+SSPI_HOT void sspi_multi_read_write(struct sspi const *const *buses, struct sspi_transfer const *xfers, size_t count)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (xfers[i].size > size) { size = xfers[i].size; }
+    }
+
+    for (size_t byte = 0; byte < size; byte++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (byte < xfers[i].size && xfers[i].read_buff) { xfers[i].read_buff[byte] = 0x00; }
+        }
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            /* Every step does the same pin operations as sspi_bit_read_write() between delays */
+            for (size_t i = 0; i < count; i++)
+            {
+                struct sspi const *const bus = buses[i];
+                if (byte >= xfers[i].size || bus->cpha_1) { continue; }
+
+                uint8_t const mask = bus->lsb ? (uint8_t)(0x01 << bit) : (uint8_t)(0x80 >> bit);
+                uint8_t const tx_byte = xfers[i].write_buff ? xfers[i].write_buff[byte] : 0x00;
+                bus->write_mosi(bus, (tx_byte & mask) ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+            }
+            buses[0]->delay(buses[0]);
+
+            /* Leading edge: CPHA 0 buses read, CPHA 1 buses write */
+            for (size_t i = 0; i < count; i++)
+            {
+                struct sspi const *const bus = buses[i];
+                if (byte >= xfers[i].size) { continue; }
+
+                uint8_t const mask = bus->lsb ? (uint8_t)(0x01 << bit) : (uint8_t)(0x80 >> bit);
+                bus->write_sck(bus, bus->cpol_1 ? SSPI_PIN_LOW : SSPI_PIN_HIGH);
+                if (bus->cpha_1)
+                {
+                    uint8_t const tx_byte = xfers[i].write_buff ? xfers[i].write_buff[byte] : 0x00;
+                    bus->write_mosi(bus, (tx_byte & mask) ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+                }
+                else if (xfers[i].read_buff && bus->read_miso(bus) == SSPI_PIN_HIGH)
+                {
+                    xfers[i].read_buff[byte] |= mask;
+                }
+            }
+            buses[0]->delay(buses[0]);
+
+            /* Trailing edge: CPHA 1 buses read */
+            for (size_t i = 0; i < count; i++)
+            {
+                struct sspi const *const bus = buses[i];
+                if (byte >= xfers[i].size) { continue; }
+
+                uint8_t const mask = bus->lsb ? (uint8_t)(0x01 << bit) : (uint8_t)(0x80 >> bit);
+                bus->write_sck(bus, bus->cpol_1 ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+                if (bus->cpha_1 && xfers[i].read_buff && bus->read_miso(bus) == SSPI_PIN_HIGH)
+                {
+                    xfers[i].read_buff[byte] |= mask;
+                }
+            }
+        }
     }
 }
\ No newline at end of file
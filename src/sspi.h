@@ -30,6 +30,19 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* Placement of the hot transfer kernels (byte and word loops with inlined bit operations).
+ * Define SSPI_HOT_SECTION with a linker section name (e.g. ".ramfunc" or ".itcm") to run them
+ * from fast memory on MCUs with flash wait states, or define SSPI_HOT with a compiler-specific
+ * attribute. By default the kernels are placed as usual.
+ * */
+#ifndef SSPI_HOT
+#ifdef SSPI_HOT_SECTION
+#define SSPI_HOT __attribute__((section(SSPI_HOT_SECTION), noinline))
+#else
+#define SSPI_HOT
+#endif
+#endif
+
 /* GPIO pin state */
 typedef enum
 {
@@ -37,6 +50,17 @@ typedef enum
     SSPI_PIN_HIGH,
 } sspi_pin_state_t;
 
+/* Ready/busy handshake policy */
+typedef enum
+{
+    /* Handshake is not used */
+    SSPI_READY_NONE = 0,
+    /* Wait for the slave once before the first word of the transaction */
+    SSPI_READY_TRANSACTION,
+    /* Wait for the slave before every 'ready_interval' words */
+    SSPI_READY_WORDS,
+} sspi_ready_policy_t;
+
 /* Software SPI bus handle */
 struct sspi
 {
@@ -70,6 +94,37 @@ struct sspi
      * For example, when the 'word_size' equals 5 and you want to send all 'ones', use value 0x1F.
      * */
     int word_size;
+    /* Optional: get state of the slave's ready line (true when ready).
+     * For slaves that hold MISO low until ready this may simply return the MISO level.
+     * */
+    bool (*is_ready)(struct sspi const *bus);
+    /* When to wait for the ready line, see sspi_ready_policy_t */
+    sspi_ready_policy_t ready_policy;
+    /* Number of words between handshakes for SSPI_READY_WORDS policy.
+     * Values 0 and 1 mean waiting before every word.
+     * */
+    size_t ready_interval;
+    /* Handshake timeout in half periods of the clock frequency: 0 means infinite wait */
+    unsigned long ready_timeout;
+    /* Number of MISO samples per bit for majority voting: 3 or 5.
+     * Values lower than 2 mean a single sample.
+     * */
+    int miso_samples;
+    /* Optional: read MISO 'count' times in a row and return the number of high samples.
+     * Use it to batch port reads; otherwise 'read_miso' is called for every sample.
+     * */
+    int (*read_miso_votes)(struct sspi const *bus, int count);
+    /* Idle time between words in half periods of the clock frequency */
+    unsigned word_gap;
+    /* Pulse CS between words: read/write operations select the slave before the first word,
+     * deselect it for at least one half period (or 'word_gap') between words and deselect it
+     * after the last word. Requires the 'write_cs' callback.
+     * */
+    bool cs_per_word;
+    /* Optional: select (true) or deselect (false) the slave.
+     * Used by the higher-level modules that run complete transactions on their own.
+     * */
+    void (*write_cs)(struct sspi const *bus, bool select);
 };
 
 /* Set SCK and MOSI pins to default state.
@@ -83,6 +138,30 @@ static inline void sspi_reset(struct sspi const *bus)
     bus->write_mosi(bus, SSPI_PIN_LOW);
 }
 
+/* Select or deselect the slave if the 'write_cs' callback is provided */
+static inline void sspi_select(struct sspi const *bus, bool select)
+{
+    if (bus->write_cs) { bus->write_cs(bus, select); }
+}
+
+/* Read MISO at the sample point, with majority voting if enabled */
+static inline sspi_pin_state_t sspi_miso_read(struct sspi const *bus)
+{
+    if (bus->miso_samples < 2) { return bus->read_miso(bus); }
+
+    int high = 0;
+    if (bus->read_miso_votes) { high = bus->read_miso_votes(bus, bus->miso_samples); }
+    else
+    {
+        for (int sample = 0; sample < bus->miso_samples; sample++)
+        {
+            if (bus->read_miso(bus) == SSPI_PIN_HIGH) { high++; }
+        }
+    }
+
+    return (2 * high > bus->miso_samples) ? SSPI_PIN_HIGH : SSPI_PIN_LOW;
+}
+
 /* Read and write one bit */
 static inline sspi_pin_state_t sspi_bit_read_write(struct sspi const *bus, sspi_pin_state_t write_bit)
 {
@@ -101,7 +180,7 @@ static inline sspi_pin_state_t sspi_bit_read_write(struct sspi const *bus, sspi_
 
         /* Read bit on the trailing edge */
         bus->write_sck(bus, sck_trail);
-        read_bit = bus->read_miso(bus);
+        read_bit = sspi_miso_read(bus);
     }
     else
     {
@@ -111,7 +190,7 @@ static inline sspi_pin_state_t sspi_bit_read_write(struct sspi const *bus, sspi_
 
         /* Read bit on the leading edge */
         bus->write_sck(bus, sck_lead);
-        read_bit = bus->read_miso(bus);
+        read_bit = sspi_miso_read(bus);
         bus->delay(bus);
 
         /* Trailing edge */
@@ -124,27 +203,77 @@ static inline sspi_pin_state_t sspi_bit_read_write(struct sspi const *bus, sspi_
 /* Read and write one byte */
 uint8_t sspi_byte_read_write(struct sspi const *bus, uint8_t write_byte);
 
+/* Read and write one byte in double data rate (DTR) mode.
+ * A bit is moved on every SCK edge: MOSI is updated before and MISO is sampled at each edge.
+ * Words are always 8 bits long, CPHA is not used.
+ * */
+uint8_t sspi_dtr_byte_read_write(struct sspi const *bus, uint8_t write_byte);
+
+/* Wait until the 'is_ready' callback reports the slave is ready.
+ * The line is polled once per half period. Returns false on timeout.
+ * Returns true at once when the callback is not set.
+ * */
+bool sspi_wait_ready(struct sspi const *bus);
+
 /* Bidirectional read/write operation.
- * Use a NULL pointer for read_buff or write_buff if you need one-directional operation. */
-void sspi_read_write(struct sspi const *bus,
+ * Use a NULL pointer for read_buff or write_buff if you need one-directional operation.
+ * Returns false if the slave did not become ready within the handshake timeout.
+ * */
+bool sspi_read_write(struct sspi const *bus,
                      uint8_t *read_buff,
                      uint8_t const *write_buff,
                      size_t size);
 
+/* Bidirectional read/write operation in double data rate (DTR) mode, see sspi_dtr_byte_read_write() */
+bool sspi_dtr_read_write(struct sspi const *bus,
+                         uint8_t *read_buff,
+                         uint8_t const *write_buff,
+                         size_t size);
+
 /* Read data array */
-static inline void sspi_read(struct sspi const *bus,
+static inline bool sspi_read(struct sspi const *bus,
                              uint8_t *read_buff,
                              size_t size)
 {
-    sspi_read_write(bus, read_buff, NULL, size);
+    return sspi_read_write(bus, read_buff, NULL, size);
 }
 
 /* Write data array */
-static inline void sspi_write(struct sspi const *bus,
+static inline bool sspi_write(struct sspi const *bus,
                               uint8_t const *write_buff,
                               size_t size)
 {
-    sspi_read_write(bus, NULL, write_buff, size);
+    return sspi_read_write(bus, NULL, write_buff, size);
 }
 
+/* Transfer descriptor: one phase of a transaction (e.g. command, address or data).
+ * Descriptors are chained with the 'next' pointer into scatter-gather lists.
+ * */
+struct sspi_transfer
+{
+    /* Buffer for the received data, may be NULL */
+    uint8_t *read_buff;
+    /* Data to send, may be NULL (zeros are sent) */
+    uint8_t const *write_buff;
+    /* Number of words */
+    size_t size;
+    /* Transfer on both SCK edges (e.g. address and data phases of DTR flash commands) */
+    bool dtr;
+    /* Next phase of the transaction or NULL */
+    struct sspi_transfer const *next;
+};
+
+/* Run the chain of transfers as one transaction.
+ * The slave is selected with the 'write_cs' callback (if provided) for the whole chain,
+ * unless CS is pulsed per word.
+ * */
+bool sspi_transfer(struct sspi const *bus, struct sspi_transfer const *xfer);
+
+/* Interleaved multi-bus transfer: every bus runs its own transfer and all buses share
+ * the delays of the first bus, so independent buses move data in parallel.
+ * Words are 8 bits long, transfers may have different sizes (0 means the bus is idle).
+ * The 'next' field, CS, handshake, framing and oversampling settings are not used.
+ * */
+void sspi_multi_read_write(struct sspi const *const *buses, struct sspi_transfer const *xfers, size_t count);
+
 #endif /* SOFTBUS_SSPI_H */
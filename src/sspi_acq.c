@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Data-ready triggered acquisition over Software SPI
+ * 
+ */
+
+#include "sspi_acq.h"
+
+#include <string.h>
+
+static inline size_t next_slot(struct sspi_acq const *acq, size_t slot)
+{
+    return (slot + 1 == acq->capacity) ? 0 : slot + 1;
+}
+
+bool sspi_acq_trigger(struct sspi_acq *acq, uint32_t timestamp)
+{
+    /* Only the producer writes 'head' */
+    size_t const head = atomic_load_explicit(&acq->head, memory_order_relaxed);
+    uint8_t *const sample = acq->samples + head * acq->sample_size;
+
+    /* The slot at 'head' is never visible to the consumer, so the transaction always runs:
+     * the sensor is serviced (and DRDY is cleared) even when the sample has to be dropped. */
+    sspi_select(acq->bus, true);
+    bool const done = sspi_write(acq->bus, acq->command, acq->command_size) &&
+                      sspi_read(acq->bus, sample, acq->sample_size);
+    sspi_select(acq->bus, false);
+
+    if (!done) { return false; }
+
+    size_t const next = next_slot(acq, head);
+    /* Acquire: the consumer is done with the slot it released */
+    if (next == atomic_load_explicit(&acq->tail, memory_order_acquire))
+    {
+        atomic_fetch_add_explicit(&acq->overruns, 1, memory_order_relaxed);
+        return false;
+    }
+
+    if (acq->timestamps) { acq->timestamps[head] = timestamp; }
+    /* Release: the sample and the timestamp are stored before the slot is published */
+    atomic_store_explicit(&acq->head, next, memory_order_release);
+    return true;
+}
+
+bool sspi_acq_pop(struct sspi_acq *acq, uint8_t *sample, uint32_t *timestamp)
+{
+    /* Only the consumer writes 'tail' */
+    size_t const tail = atomic_load_explicit(&acq->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&acq->head, memory_order_acquire)) { return false; }
+
+    memcpy(sample, acq->samples + tail * acq->sample_size, acq->sample_size);
+    if (timestamp) { *timestamp = acq->timestamps ? acq->timestamps[tail] : 0; }
+    /* Release: the slot is copied out before it is handed back to the producer */
+    atomic_store_explicit(&acq->tail, next_slot(acq, tail), memory_order_release);
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Data-ready triggered acquisition over Software SPI
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_ACQ_H
+#define SOFTBUS_SSPI_ACQ_H
+
+#include "sspi.h"
+
+#include <stdatomic.h>
+
+/* Data-ready triggered acquisition.
+ * Call sspi_acq_trigger() on the DRDY edge (from the interrupt handler or from a worker
+ * woken by it): the pre-built read transaction runs immediately and the sample is stored
+ * to a ring buffer together with the DRDY timestamp. Use sspi_acq_pop() to take samples.
+ * The ring buffer is lock-free for one producer and one consumer: indices are published
+ * with release stores and read with acquire loads, so slot contents are never seen half-written.
+ * */
+struct sspi_acq
+{
+    /* Bus connected to the sensor. The 'write_cs' callback is used to select the sensor. */
+    struct sspi const *bus;
+    /* Bytes written at the beginning of the transaction (e.g. read command). May be NULL. */
+    uint8_t const *command;
+    /* Size of the command in bytes */
+    size_t command_size;
+    /* Number of bytes read after the command */
+    size_t sample_size;
+    /* Sample storage: 'capacity' * 'sample_size' bytes */
+    uint8_t *samples;
+    /* Optional timestamp storage: 'capacity' entries */
+    uint32_t *timestamps;
+    /* Number of slots. One slot is reserved for the running transaction,
+     * so up to 'capacity - 1' samples may be queued.
+     * */
+    size_t capacity;
+    /* Index of the slot for the next sample (zero on start) */
+    atomic_size_t head;
+    /* Index of the oldest queued sample (zero on start) */
+    atomic_size_t tail;
+    /* Number of samples dropped because the ring buffer was full */
+    atomic_size_t overruns;
+};
+
+/* Run the read transaction and queue the sample.
+ * Returns false if the sample was dropped because of an overrun or a handshake timeout.
+ * */
+bool sspi_acq_trigger(struct sspi_acq *acq, uint32_t timestamp);
+
+/* Take the oldest sample: 'sample_size' bytes are copied to the 'sample' buffer.
+ * The 'timestamp' pointer may be NULL. Returns false if there are no samples.
+ * */
+bool sspi_acq_pop(struct sspi_acq *acq, uint8_t *sample, uint32_t *timestamp);
+
+/* Get number of queued samples */
+static inline size_t sspi_acq_count(struct sspi_acq const *acq)
+{
+    size_t const head = atomic_load_explicit(&acq->head, memory_order_acquire);
+    size_t const tail = atomic_load_explicit(&acq->tail, memory_order_acquire);
+    return (head >= tail) ? head - tail : acq->capacity - tail + head;
+}
+
+#endif /* SOFTBUS_SSPI_ACQ_H */
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * SPI NOR flash driver over Software SPI
+ * 
+ */
+
+#include "sspi_flash.h"
+
+/* Select the flash and send a command with an optional 24-bit address */
+static bool flash_command(struct sspi_flash const *flash, uint8_t cmd, bool with_addr, uint32_t addr)
+{
+    uint8_t const header[] = {cmd, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+
+    sspi_select(flash->bus, true);
+    return sspi_write(flash->bus, header, with_addr ? sizeof(header) : 1);
+}
+
+/* Send a command without data phase */
+static bool flash_simple_command(struct sspi_flash const *flash, uint8_t cmd, bool with_addr, uint32_t addr)
+{
+    bool const done = flash_command(flash, cmd, with_addr, addr);
+    sspi_select(flash->bus, false);
+    return done;
+}
+
+bool sspi_flash_wait(struct sspi_flash const *flash)
+{
+    uint8_t status = SSPI_FLASH_STATUS_BUSY;
+    bool done = flash_command(flash, SSPI_FLASH_CMD_READ_STATUS, false, 0);
+
+    /* Status register is sent continuously while the flash is selected */
+    for (unsigned long polls = 0; done && (status & SSPI_FLASH_STATUS_BUSY); polls++)
+    {
+        if (flash->busy_timeout && polls >= flash->busy_timeout)
+        {
+            done = false;
+            break;
+        }
+        done = sspi_read(flash->bus, &status, 1);
+    }
+
+    sspi_select(flash->bus, false);
+    return done;
+}
+
+bool sspi_flash_read(struct sspi_flash const *flash, uint32_t addr, uint8_t *buff, size_t size)
+{
+    bool const done = flash_command(flash, SSPI_FLASH_CMD_READ, true, addr) &&
+                      sspi_read(flash->bus, buff, size);
+    sspi_select(flash->bus, false);
+    return done;
+}
+
+bool sspi_flash_erase_sector(struct sspi_flash const *flash, uint32_t addr)
+{
+    return flash_simple_command(flash, SSPI_FLASH_CMD_WRITE_ENABLE, false, 0) &&
+           flash_simple_command(flash, SSPI_FLASH_CMD_SECTOR_ERASE, true, addr) &&
+           sspi_flash_wait(flash);
+}
+
+bool sspi_flash_program(struct sspi_flash const *flash, uint32_t addr, uint8_t const *data, size_t size)
+{
+    while (size)
+    {
+        size_t const page_left = flash->page_size - addr % flash->page_size;
+        size_t const chunk = (size < page_left) ? size : page_left;
+
+        bool const done = flash_simple_command(flash, SSPI_FLASH_CMD_WRITE_ENABLE, false, 0) &&
+                          flash_command(flash, SSPI_FLASH_CMD_PAGE_PROGRAM, true, addr) &&
+                          sspi_write(flash->bus, data, chunk);
+        sspi_select(flash->bus, false);
+        if (!done || !sspi_flash_wait(flash)) { return false; }
+
+        addr += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+bool sspi_flash_program_stream(struct sspi_flash const *flash,
+                               uint32_t addr,
+                               sspi_flash_source_t source,
+                               void *ctx,
+                               size_t *size)
+{
+    uint8_t chunk[SSPI_FLASH_CHUNK_SIZE];
+    size_t total = 0;
+    bool done = true;
+    bool end = false;
+
+    while (done && !end)
+    {
+        size_t page_left = flash->page_size - addr % flash->page_size;
+        size_t request = (page_left < sizeof(chunk)) ? page_left : sizeof(chunk);
+
+        /* Pull the first chunk before the command, so the end of the stream
+         * never produces an empty page program operation */
+        size_t count = source(ctx, chunk, request);
+        if (!count) { break; }
+
+        done = flash_simple_command(flash, SSPI_FLASH_CMD_WRITE_ENABLE, false, 0) &&
+               flash_command(flash, SSPI_FLASH_CMD_PAGE_PROGRAM, true, addr);
+
+        while (done && count)
+        {
+            done = sspi_write(flash->bus, chunk, count);
+            addr += count;
+            total += count;
+            page_left -= count;
+
+            end = count < request;
+            request = end ? 0 : (page_left < sizeof(chunk)) ? page_left : sizeof(chunk);
+            count = request ? source(ctx, chunk, request) : 0;
+        }
+
+        sspi_select(flash->bus, false);
+        done = done && sspi_flash_wait(flash);
+    }
+
+    if (size) { *size = total; }
+    return done;
+}
+
+uint32_t sspi_flash_crc32_update(uint32_t crc, uint8_t const *data, size_t size)
+{
+    /* Half-byte table keeps the code small for MCUs */
+    static uint32_t const table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+
+    crc = ~crc;
+    while (size--)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+bool sspi_flash_crc32(struct sspi_flash const *flash, uint32_t addr, size_t size, uint32_t *crc)
+{
+    uint8_t chunk[SSPI_FLASH_CHUNK_SIZE];
+    bool done = flash_command(flash, SSPI_FLASH_CMD_READ, true, addr);
+
+    *crc = 0;
+    while (done && size)
+    {
+        size_t const count = (size < sizeof(chunk)) ? size : sizeof(chunk);
+        done = sspi_read(flash->bus, chunk, count);
+        *crc = sspi_flash_crc32_update(*crc, chunk, count);
+        size -= count;
+    }
+
+    sspi_select(flash->bus, false);
+    return done;
+}
+
+/* Check if the data equals to the erased state */
+static bool is_erased(uint8_t const *data, size_t size)
+{
+    while (size--)
+    {
+        if (*data++ != 0xFF) { return false; }
+    }
+
+    return true;
+}
+
+bool sspi_flash_update(struct sspi_flash const *flash,
+                       uint32_t addr,
+                       uint8_t const *image,
+                       size_t size,
+                       size_t *updated)
+{
+    size_t rewritten = 0;
+    bool done = true;
+
+    for (size_t offset = 0; done && offset < size; offset += flash->sector_size)
+    {
+        size_t const count = (size - offset < flash->sector_size) ? size - offset : flash->sector_size;
+        uint8_t const *const data = image + offset;
+        uint32_t expected = sspi_flash_crc32_update(0, data, count);
+        uint32_t crc;
+
+        /* The whole sector is compared: the part past the end of the image must be erased */
+        for (size_t tail = count; tail < flash->sector_size; tail++)
+        {
+            static uint8_t const erased = 0xFF;
+            expected = sspi_flash_crc32_update(expected, &erased, 1);
+        }
+
+        done = sspi_flash_crc32(flash, addr + offset, flash->sector_size, &crc);
+        if (!done || crc == expected) { continue; }
+
+        done = sspi_flash_erase_sector(flash, addr + offset);
+        for (size_t page = 0; done && page < count; page += flash->page_size)
+        {
+            size_t const page_count = (count - page < flash->page_size) ? count - page : flash->page_size;
+            if (is_erased(data + page, page_count)) { continue; }
+            done = sspi_flash_program(flash, addr + offset + page, data + page, page_count);
+        }
+        if (done) { rewritten++; }
+    }
+
+    if (updated) { *updated = rewritten; }
+    return done;
+}
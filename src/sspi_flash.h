@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * SPI NOR flash driver over Software SPI
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_FLASH_H
+#define SOFTBUS_SSPI_FLASH_H
+
+#include "sspi.h"
+
+/* Common SPI NOR flash commands */
+#define SSPI_FLASH_CMD_WRITE_ENABLE 0x06
+#define SSPI_FLASH_CMD_READ_STATUS 0x05
+#define SSPI_FLASH_CMD_READ 0x03
+#define SSPI_FLASH_CMD_PAGE_PROGRAM 0x02
+#define SSPI_FLASH_CMD_SECTOR_ERASE 0x20
+
+/* Write-in-progress bit of the status register */
+#define SSPI_FLASH_STATUS_BUSY 0x01
+
+/* Size of the stack buffer used to pull data from a stream source */
+#ifndef SSPI_FLASH_CHUNK_SIZE
+#define SSPI_FLASH_CHUNK_SIZE 16
+#endif
+
+/* SPI NOR flash with 24-bit addressing */
+struct sspi_flash
+{
+    /* Bus connected to the flash. The 'write_cs' callback is required. */
+    struct sspi const *bus;
+    /* Page size in bytes (usually 256) */
+    size_t page_size;
+    /* Erase sector size in bytes (usually 4096) */
+    size_t sector_size;
+    /* Maximum number of status register reads while waiting for program or erase: 0 means infinite */
+    unsigned long busy_timeout;
+};
+
+/* Data source for streaming operations.
+ * Fill up to 'size' bytes of the buffer and return the number of bytes written.
+ * Returning less than 'size' means the end of the stream.
+ * */
+typedef size_t (*sspi_flash_source_t)(void *ctx, uint8_t *buff, size_t size);
+
+/* Wait until program or erase operation is finished. Returns false on timeout. */
+bool sspi_flash_wait(struct sspi_flash const *flash);
+
+/* Read data array */
+bool sspi_flash_read(struct sspi_flash const *flash, uint32_t addr, uint8_t *buff, size_t size);
+
+/* Erase the sector containing the address */
+bool sspi_flash_erase_sector(struct sspi_flash const *flash, uint32_t addr);
+
+/* Program data array. The area must be erased. Writes are split on page boundaries. */
+bool sspi_flash_program(struct sspi_flash const *flash, uint32_t addr, uint8_t const *data, size_t size);
+
+/* Program data pulled from the source until the end of the stream.
+ * Data goes straight to the page program data phase in chunks of SSPI_FLASH_CHUNK_SIZE bytes,
+ * so the source (e.g. a decompressor) never needs a page-sized output buffer.
+ * The number of programmed bytes is stored to 'size' (may be NULL). The area must be erased.
+ * */
+bool sspi_flash_program_stream(struct sspi_flash const *flash,
+                               uint32_t addr,
+                               sspi_flash_source_t source,
+                               void *ctx,
+                               size_t *size);
+
+/* Update CRC-32 (IEEE 802.3) of the data. Start with the value 0. */
+uint32_t sspi_flash_crc32_update(uint32_t crc, uint8_t const *data, size_t size);
+
+/* Calculate CRC-32 of the flash contents while reading it: the data is never buffered */
+bool sspi_flash_crc32(struct sspi_flash const *flash, uint32_t addr, size_t size, uint32_t *crc);
+
+/* Differential update: erase and program only the sectors that differ from the image.
+ * Sectors are compared by CRC-32 of the device contents, so update time scales with the size
+ * of the change. Pages of the image filled with 0xFF are not programmed.
+ * The address must be aligned to the sector size. When the image ends in the middle of a sector,
+ * the rest of that sector is expected to be erased: it is compared too and erased if it is not.
+ * The number of successfully rewritten sectors is stored to 'updated' (may be NULL).
+ * */
+bool sspi_flash_update(struct sspi_flash const *flash,
+                       uint32_t addr,
+                       uint8_t const *image,
+                       size_t size,
+                       size_t *updated);
+
+#endif /* SOFTBUS_SSPI_FLASH_H */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Gang programming of SPI NOR flash chips over parallel lanes
+ * 
+ */
+
+#include "sspi_gang.h"
+
+/* Mask of all used lanes */
+static inline uint32_t lanes_mask(struct sspi_gang const *gang)
+{
+    return (gang->lanes >= SSPI_GANG_LANES_MAX) ? UINT32_MAX : ((uint32_t)1 << gang->lanes) - 1;
+}
+
+/* Write data to all lanes, the responses are ignored */
+static void gang_write(struct sspi_gang const *gang, uint8_t const *data, size_t size)
+{
+    while (size--) { sspi_gang_byte_read_write(gang, *data++, NULL); }
+}
+
+/* Select the chips and send a command with an optional 24-bit address */
+static void gang_command(struct sspi_gang const *gang, uint8_t cmd, bool with_addr, uint32_t addr)
+{
+    uint8_t const header[] = {cmd, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+
+    sspi_select(gang->flash->bus, true);
+    gang_write(gang, header, with_addr ? sizeof(header) : 1);
+}
+
+/* Send a command without data phase */
+static void gang_simple_command(struct sspi_gang const *gang, uint8_t cmd, bool with_addr, uint32_t addr)
+{
+    gang_command(gang, cmd, with_addr, addr);
+    sspi_select(gang->flash->bus, false);
+}
+
+uint32_t sspi_gang_bit_read_write(struct sspi_gang const *gang, sspi_pin_state_t write_bit)
+{
+    struct sspi const *const bus = gang->flash->bus;
+    sspi_pin_state_t const sck_lead = bus->cpol_1 ? SSPI_PIN_LOW : SSPI_PIN_HIGH;
+    sspi_pin_state_t const sck_trail = bus->cpol_1 ? SSPI_PIN_HIGH : SSPI_PIN_LOW;
+    uint32_t read_bits;
+
+    if (bus->cpha_1)
+    {
+        bus->delay(bus);
+
+        /* Write bit on the leading edge */
+        bus->write_sck(bus, sck_lead);
+        bus->write_mosi(bus, write_bit);
+        bus->delay(bus);
+
+        /* Read bits on the trailing edge */
+        bus->write_sck(bus, sck_trail);
+        read_bits = gang->read_miso(gang);
+    }
+    else
+    {
+        /* Write bit */
+        bus->write_mosi(bus, write_bit);
+        bus->delay(bus);
+
+        /* Read bits on the leading edge */
+        bus->write_sck(bus, sck_lead);
+        read_bits = gang->read_miso(gang);
+        bus->delay(bus);
+
+        /* Trailing edge */
+        bus->write_sck(bus, sck_trail);
+    }
+
+    return read_bits;
+}
+
+void sspi_gang_byte_read_write(struct sspi_gang const *gang, uint8_t write_byte, uint8_t *read_bytes)
+{
+    bool const lsb = gang->flash->bus->lsb;
+
+    if (read_bytes)
+    {
+        for (int lane = 0; lane < gang->lanes; lane++) { read_bytes[lane] = 0; }
+    }
+
+    for (int bit = 0; bit < 8; bit++)
+    {
+        uint8_t const mask = lsb ? (uint8_t)(0x01 << bit) : (uint8_t)(0x80 >> bit);
+        uint32_t const read_bits = sspi_gang_bit_read_write(gang, (write_byte & mask) ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+
+        if (!read_bytes) { continue; }
+        for (int lane = 0; lane < gang->lanes; lane++)
+        {
+            if (read_bits & ((uint32_t)1 << lane)) { read_bytes[lane] |= mask; }
+        }
+    }
+}
+
+uint32_t sspi_gang_wait(struct sspi_gang const *gang, uint32_t lanes)
+{
+    uint8_t status[SSPI_GANG_LANES_MAX];
+    uint32_t busy = lanes & lanes_mask(gang);
+
+    /* A missing chip reads as always busy: without a timeout the wait would never end */
+    if (!busy || !gang->flash->busy_timeout) { return busy; }
+
+    gang_command(gang, SSPI_FLASH_CMD_READ_STATUS, false, 0);
+
+    /* Status registers of all chips are read in parallel until every chip is ready */
+    for (unsigned long polls = 0; busy && polls < gang->flash->busy_timeout; polls++)
+    {
+        sspi_gang_byte_read_write(gang, 0x00, status);
+        for (int lane = 0; lane < gang->lanes; lane++)
+        {
+            if (!(status[lane] & SSPI_FLASH_STATUS_BUSY)) { busy &= ~((uint32_t)1 << lane); }
+        }
+    }
+
+    sspi_select(gang->flash->bus, false);
+    return busy;
+}
+
+uint32_t sspi_gang_erase_sector(struct sspi_gang const *gang, uint32_t addr, uint32_t lanes)
+{
+    if (!gang->flash->busy_timeout) { return lanes & lanes_mask(gang); }
+
+    gang_simple_command(gang, SSPI_FLASH_CMD_WRITE_ENABLE, false, 0);
+    gang_simple_command(gang, SSPI_FLASH_CMD_SECTOR_ERASE, true, addr);
+    return sspi_gang_wait(gang, lanes);
+}
+
+uint32_t sspi_gang_program(struct sspi_gang const *gang,
+                           uint32_t addr,
+                           uint8_t const *data,
+                           size_t size,
+                           uint32_t lanes)
+{
+    size_t const page_size = gang->flash->page_size;
+    uint32_t failed = 0;
+
+    if (!gang->flash->busy_timeout) { return lanes & lanes_mask(gang); }
+
+    while (size)
+    {
+        size_t const page_left = page_size - addr % page_size;
+        size_t const chunk = (size < page_left) ? size : page_left;
+
+        gang_simple_command(gang, SSPI_FLASH_CMD_WRITE_ENABLE, false, 0);
+        gang_command(gang, SSPI_FLASH_CMD_PAGE_PROGRAM, true, addr);
+        gang_write(gang, data, chunk);
+        sspi_select(gang->flash->bus, false);
+        /* Failed lanes are not waited for again */
+        failed |= sspi_gang_wait(gang, lanes & ~failed);
+
+        addr += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+
+    return failed;
+}
+
+uint32_t sspi_gang_verify(struct sspi_gang const *gang, uint32_t addr, uint8_t const *data, size_t size)
+{
+    uint8_t read_bytes[SSPI_GANG_LANES_MAX];
+    uint32_t failed = 0;
+
+    gang_command(gang, SSPI_FLASH_CMD_READ, true, addr);
+
+    while (size--)
+    {
+        sspi_gang_byte_read_write(gang, 0x00, read_bytes);
+        for (int lane = 0; lane < gang->lanes; lane++)
+        {
+            if (read_bytes[lane] != *data) { failed |= (uint32_t)1 << lane; }
+        }
+        data++;
+    }
+
+    sspi_select(gang->flash->bus, false);
+    return failed;
+}
+
+uint32_t sspi_gang_write_image(struct sspi_gang const *gang, uint32_t addr, uint8_t const *data, size_t size)
+{
+    size_t const sector_size = gang->flash->sector_size;
+    uint32_t failed = 0;
+
+    /* The chips would be erased with no way to finish the update */
+    if (!gang->flash->busy_timeout) { return lanes_mask(gang); }
+
+    for (uint32_t sector = addr - addr % sector_size; sector < addr + size; sector += sector_size)
+    {
+        failed |= sspi_gang_erase_sector(gang, sector, ~failed);
+    }
+
+    failed |= sspi_gang_program(gang, addr, data, size, ~failed);
+    failed |= sspi_gang_verify(gang, addr, data, size);
+    return failed & lanes_mask(gang);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Gang programming of SPI NOR flash chips over parallel lanes
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_GANG_H
+#define SOFTBUS_SSPI_GANG_H
+
+#include "sspi_flash.h"
+
+/* Maximum number of lanes */
+#define SSPI_GANG_LANES_MAX 32
+
+/* Identical flash chips wired with shared SCK, CS and MOSI and separate MISO lanes.
+ * Commands and data are broadcast to every chip, responses are read from all lanes in parallel.
+ * Functions return a bit mask of failed lanes: bit N is set when the chip on lane N failed.
+ * The 'busy_timeout' of the flash must be set: a missing chip never reports ready.
+ * Unlike sspi_flash, where 0 means an infinite wait, functions that wait reject the timeout 0
+ * and report every requested lane as failed without sending any command.
+ * */
+struct sspi_gang
+{
+    /* Geometry of the chips and the shared bus.
+     * The bus 'write_mosi' callback must drive MOSI of every lane, 'read_miso' is not used.
+     * */
+    struct sspi_flash const *flash;
+    /* Get MISO states of all lanes: bit N is the state of lane N */
+    uint32_t (*read_miso)(struct sspi_gang const *gang);
+    /* Number of lanes: 1-32 */
+    int lanes;
+};
+
+/* Write one bit to all lanes and read one bit from every lane */
+uint32_t sspi_gang_bit_read_write(struct sspi_gang const *gang, sspi_pin_state_t write_bit);
+
+/* Write one byte to all lanes and read one byte from every lane.
+ * The 'read_bytes' array has an entry per lane and may be NULL.
+ * */
+void sspi_gang_byte_read_write(struct sspi_gang const *gang, uint8_t write_byte, uint8_t *read_bytes);
+
+/* Wait until the chips on the lanes from the mask finish program or erase operation.
+ * Returns the lanes still busy on timeout.
+ * */
+uint32_t sspi_gang_wait(struct sspi_gang const *gang, uint32_t lanes);
+
+/* Erase the sector containing the address on every chip, waiting for the lanes from the mask */
+uint32_t sspi_gang_erase_sector(struct sspi_gang const *gang, uint32_t addr, uint32_t lanes);
+
+/* Program data array to every chip, waiting for the lanes from the mask. The area must be erased.
+ * A lane that times out is not waited for on the following pages.
+ * */
+uint32_t sspi_gang_program(struct sspi_gang const *gang,
+                           uint32_t addr,
+                           uint8_t const *data,
+                           size_t size,
+                           uint32_t lanes);
+
+/* Read back every chip and compare with the data */
+uint32_t sspi_gang_verify(struct sspi_gang const *gang, uint32_t addr, uint8_t const *data, size_t size);
+
+/* Erase the sectors covered by the image, program and verify it.
+ * Lanes that fail at any stage are reported and dropped from the following waits,
+ * the rest of the chips are still processed.
+ * */
+uint32_t sspi_gang_write_image(struct sspi_gang const *gang, uint32_t addr, uint8_t const *data, size_t size);
+
+#endif /* SOFTBUS_SSPI_GANG_H */
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Heatshrink (LZSS) stream decoder
+ * 
+ */
+
+#include "sspi_heatshrink.h"
+
+#include <string.h>
+
+/* Get bits in MSB-first order. Returns -1 at the end of the input. */
+static int get_bits(struct sspi_heatshrink *hs, int count)
+{
+    int value = 0;
+
+    while (count--)
+    {
+        if (!hs->bit_mask)
+        {
+            if (hs->input_pos == hs->input_size) { return -1; }
+            hs->current_byte = hs->input[hs->input_pos++];
+            hs->bit_mask = 0x80;
+        }
+
+        value = (value << 1) | ((hs->current_byte & hs->bit_mask) ? 1 : 0);
+        hs->bit_mask >>= 1;
+    }
+
+    return value;
+}
+
+void sspi_heatshrink_reset(struct sspi_heatshrink *hs)
+{
+    memset(hs->window, 0, (size_t)1 << hs->window_bits);
+    hs->input_pos = 0;
+    hs->head = 0;
+    hs->backref_offset = 0;
+    hs->backref_count = 0;
+    hs->bit_mask = 0;
+    hs->current_byte = 0;
+}
+
+size_t sspi_heatshrink_read(void *ctx, uint8_t *buff, size_t size)
+{
+    struct sspi_heatshrink *const hs = ctx;
+    size_t const mask = ((size_t)1 << hs->window_bits) - 1;
+    size_t count = 0;
+
+    while (count < size)
+    {
+        int c;
+
+        if (hs->backref_count)
+        {
+            /* Copy from the window */
+            c = hs->window[(hs->head - hs->backref_offset) & mask];
+            hs->backref_count--;
+        }
+        else
+        {
+            int const tag = get_bits(hs, 1);
+            if (tag < 0) { break; }
+
+            if (tag)
+            {
+                /* Literal byte */
+                c = get_bits(hs, 8);
+                if (c < 0) { break; }
+            }
+            else
+            {
+                /* Back reference: offset and count are stored minus one */
+                int const index = get_bits(hs, hs->window_bits);
+                int const length = get_bits(hs, hs->lookahead_bits);
+                if (index < 0 || length < 0) { break; }
+                hs->backref_offset = (uint16_t)(index + 1);
+                hs->backref_count = (uint16_t)(length + 1);
+                continue;
+            }
+        }
+
+        hs->window[hs->head++ & mask] = (uint8_t)c;
+        buff[count++] = (uint8_t)c;
+    }
+
+    return count;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Heatshrink (LZSS) stream decoder
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_HEATSHRINK_H
+#define SOFTBUS_SSPI_HEATSHRINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Decoder of heatshrink compressed data.
+ * The window size (-w) and lookahead size (-l) must match the encoder settings.
+ * Small windows (e.g. -w 8 -l 4) keep working RAM at the size of a flash page.
+ * */
+struct sspi_heatshrink
+{
+    /* Compressed data */
+    uint8_t const *input;
+    size_t input_size;
+    /* Window buffer: (1 << window_bits) bytes */
+    uint8_t *window;
+    /* Base-2 log of the window size: 4-15 */
+    int window_bits;
+    /* Base-2 log of the lookahead size: 3 to 'window_bits - 1' */
+    int lookahead_bits;
+    /* Decoder state, initialized by sspi_heatshrink_reset() */
+    size_t input_pos;
+    size_t head;
+    uint16_t backref_offset;
+    uint16_t backref_count;
+    uint8_t bit_mask;
+    uint8_t current_byte;
+};
+
+/* Start decoding from the beginning of the input */
+void sspi_heatshrink_reset(struct sspi_heatshrink *hs);
+
+/* Decode up to 'size' bytes. Returns less than 'size' at the end of the data.
+ * The signature matches the flash stream source: pass the decoder as the context.
+ * */
+size_t sspi_heatshrink_read(void *hs, uint8_t *buff, size_t size);
+
+#endif /* SOFTBUS_SSPI_HEATSHRINK_H */
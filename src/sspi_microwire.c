@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Microwire (93Cxx) EEPROM driver over Software SPI
+ * 
+ */
+
+#include "sspi_microwire.h"
+
+/* Write DI and read DO with one SK pulse, MSB first.
+ * The device latches DI and starts driving the next DO bit on the rising edge, but DO settles only
+ * after the output delay (tPD), so it is sampled at the end of the high phase instead of at the edge.
+ * */
+static uint32_t microwire_bits(struct sspi_microwire const *mw, uint32_t write_bits, int count)
+{
+    struct sspi const *const bus = mw->bus;
+    uint32_t read_bits = 0;
+
+    for (int bit = count - 1; bit >= 0; bit--)
+    {
+        bus->write_mosi(bus, ((write_bits >> bit) & 1) ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+        bus->delay(bus);
+        bus->write_sck(bus, SSPI_PIN_HIGH);
+        bus->delay(bus);
+        read_bits |= (sspi_miso_read(bus) == SSPI_PIN_HIGH) ? (uint32_t)1 << bit : 0;
+        bus->write_sck(bus, SSPI_PIN_LOW);
+    }
+
+    return read_bits;
+}
+
+/* Select the device and send the instruction: start bit, opcode and address.
+ * Returns the bits read during the instruction, the last one is the dummy zero of READ.
+ * */
+static uint32_t microwire_instruction(struct sspi_microwire const *mw, uint32_t op, uint32_t addr)
+{
+    uint32_t const addr_mask = ((uint32_t)1 << mw->addr_bits) - 1;
+    uint32_t const frame = (uint32_t)1 << (mw->addr_bits + 2) | op << mw->addr_bits | (addr & addr_mask);
+
+    sspi_select(mw->bus, true);
+    return microwire_bits(mw, frame, mw->addr_bits + 3);
+}
+
+/* Deselect the device keeping CS low for at least one half period */
+static void microwire_deselect(struct sspi_microwire const *mw)
+{
+    sspi_select(mw->bus, false);
+    mw->bus->delay(mw->bus);
+}
+
+bool sspi_microwire_wait(struct sspi_microwire const *mw)
+{
+    bool done = false;
+
+    /* DO shows the ready state while the device is selected */
+    sspi_select(mw->bus, true);
+    for (unsigned long polls = 0; !mw->busy_timeout || polls < mw->busy_timeout; polls++)
+    {
+        mw->bus->delay(mw->bus);
+        if (sspi_miso_read(mw->bus) == SSPI_PIN_HIGH)
+        {
+            done = true;
+            break;
+        }
+    }
+    microwire_deselect(mw);
+    return done;
+}
+
+bool sspi_microwire_read(struct sspi_microwire const *mw, uint32_t addr, uint16_t *words, size_t count)
+{
+    bool const dummy_zero = (microwire_instruction(mw, SSPI_MICROWIRE_OP_READ, addr) & 0x01) == 0;
+
+    /* Words follow each other while the clock runs */
+    for (size_t i = 0; dummy_zero && i < count; i++)
+    {
+        words[i] = (uint16_t)microwire_bits(mw, 0, mw->word_bits);
+    }
+
+    microwire_deselect(mw);
+    return dummy_zero;
+}
+
+void sspi_microwire_write_enable(struct sspi_microwire const *mw, bool enable)
+{
+    uint32_t const ext = enable ? SSPI_MICROWIRE_EXT_EWEN : SSPI_MICROWIRE_EXT_EWDS;
+
+    microwire_instruction(mw, SSPI_MICROWIRE_OP_EXTENDED, ext << (mw->addr_bits - 2));
+    microwire_deselect(mw);
+}
+
+bool sspi_microwire_write(struct sspi_microwire const *mw, uint32_t addr, uint16_t word)
+{
+    microwire_instruction(mw, SSPI_MICROWIRE_OP_WRITE, addr);
+    microwire_bits(mw, word, mw->word_bits);
+    microwire_deselect(mw);
+    return sspi_microwire_wait(mw);
+}
+
+bool sspi_microwire_erase(struct sspi_microwire const *mw, uint32_t addr)
+{
+    microwire_instruction(mw, SSPI_MICROWIRE_OP_ERASE, addr);
+    microwire_deselect(mw);
+    return sspi_microwire_wait(mw);
+}
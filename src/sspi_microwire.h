@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Microwire (93Cxx) EEPROM driver over Software SPI
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_MICROWIRE_H
+#define SOFTBUS_SSPI_MICROWIRE_H
+
+#include "sspi.h"
+
+/* Instruction opcodes (2 bits after the start bit) */
+#define SSPI_MICROWIRE_OP_EXTENDED 0x0
+#define SSPI_MICROWIRE_OP_WRITE 0x1
+#define SSPI_MICROWIRE_OP_READ 0x2
+#define SSPI_MICROWIRE_OP_ERASE 0x3
+
+/* Extended instructions: two most significant address bits */
+#define SSPI_MICROWIRE_EXT_EWDS 0x0
+#define SSPI_MICROWIRE_EXT_EWEN 0x3
+
+/* Microwire EEPROM (93C46-93C86).
+ * An instruction is a start bit, an opcode and an address of any width, so it is sent as one
+ * bit-exact frame. Reads stream the array sequentially after one instruction.
+ * */
+struct sspi_microwire
+{
+    /* Bus with SK idling low, the 'cpol_1', 'cpha_1', 'lsb' and 'word_size' settings are not used.
+     * The 'write_cs' callback is required: Microwire CS is active high, so selecting must drive the pin high.
+     * */
+    struct sspi const *bus;
+    /* Address width: depends on the size and organization (e.g. 6 for 93C46 x16, 7 for 93C46 x8) */
+    int addr_bits;
+    /* Word width set by the ORG pin: 8 or 16 */
+    int word_bits;
+    /* Maximum number of DO polls while waiting for write or erase: 0 means infinite */
+    unsigned long busy_timeout;
+};
+
+/* Read words sequentially starting from the address. The address increments and wraps inside the device,
+ * so the whole array is read with one instruction. Returns false if the dummy zero bit is missing.
+ * */
+bool sspi_microwire_read(struct sspi_microwire const *mw, uint32_t addr, uint16_t *words, size_t count);
+
+/* Enable (EWEN) or disable (EWDS) write and erase instructions */
+void sspi_microwire_write_enable(struct sspi_microwire const *mw, bool enable);
+
+/* Write one word and wait until it is programmed. Writes must be enabled. */
+bool sspi_microwire_write(struct sspi_microwire const *mw, uint32_t addr, uint16_t word);
+
+/* Erase one word to all ones and wait until it is done. Writes must be enabled. */
+bool sspi_microwire_erase(struct sspi_microwire const *mw, uint32_t addr);
+
+/* Wait until DO reports ready after a write or erase. Returns false on timeout. */
+bool sspi_microwire_wait(struct sspi_microwire const *mw);
+
+#endif /* SOFTBUS_SSPI_MICROWIRE_H */
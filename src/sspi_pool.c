@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Fixed-capacity pools for transfer descriptors and payloads
+ * 
+ */
+
+#include "sspi_pool.h"
+
+void *sspi_pool_alloc(struct sspi_pool *pool)
+{
+    void *block = pool->free_list;
+
+    if (block) { pool->free_list = *(void **)block; }
+    else if (pool->untouched < pool->capacity)
+    {
+        /* Blocks are taken in order after a reset, so the reset does not rebuild the free list */
+        block = (uint8_t *)pool->storage + pool->untouched++ * pool->block_size;
+    }
+    else
+    {
+        return NULL;
+    }
+
+    if (++pool->used > pool->high_water) { pool->high_water = pool->used; }
+    return block;
+}
+
+void sspi_pool_free(struct sspi_pool *pool, void *block)
+{
+    if (!block) { return; }
+
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->used--;
+}
+
+void sspi_pool_reset(struct sspi_pool *pool)
+{
+    pool->free_list = NULL;
+    pool->untouched = 0;
+    pool->used = 0;
+}
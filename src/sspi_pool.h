@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Fixed-capacity pools for transfer descriptors and payloads
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_POOL_H
+#define SOFTBUS_SSPI_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fixed-capacity pool of equally sized blocks, e.g. transfer descriptors or payload slots.
+ * Allocation, freeing and bulk reset take constant time and never touch the heap.
+ * */
+struct sspi_pool
+{
+    /* Storage: 'capacity' blocks of 'block_size' bytes */
+    void *storage;
+    /* Block size in bytes: a multiple of the required alignment, not less than sizeof(void *) */
+    size_t block_size;
+    /* Number of blocks */
+    size_t capacity;
+    /* Freed blocks linked through their first bytes (NULL on start) */
+    void *free_list;
+    /* Index of the first block not allocated since the last reset (zero on start) */
+    size_t untouched;
+    /* Number of allocated blocks */
+    size_t used;
+    /* Maximum number of allocated blocks, kept across resets */
+    size_t high_water;
+};
+
+/* Define a static pool of 'count' blocks of 'size' bytes with suitable storage */
+#define SSPI_POOL_DEFINE(name, size, count)        \
+    static union {                                 \
+        max_align_t align;                         \
+        uint8_t block[size];                       \
+    } name##_storage[count];                       \
+    static struct sspi_pool name = {               \
+        .storage = name##_storage,                 \
+        .block_size = sizeof(name##_storage[0]),   \
+        .capacity = (count),                       \
+    }
+
+/* Allocate a block. Returns NULL when the pool is exhausted. */
+void *sspi_pool_alloc(struct sspi_pool *pool);
+
+/* Return the block to the pool */
+void sspi_pool_free(struct sspi_pool *pool, void *block);
+
+/* Free all blocks at once, e.g. after a batch of transfers is complete */
+void sspi_pool_reset(struct sspi_pool *pool);
+
+#endif /* SOFTBUS_SSPI_POOL_H */
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * SPI PSRAM driver with a memory pool and a write-back cache
+ * 
+ */
+
+#include "sspi_psram.h"
+
+static inline bool bit_get(uint32_t const *map, size_t index)
+{
+    return map[index / 32] & ((uint32_t)1 << (index % 32));
+}
+
+static inline void bit_set(uint32_t *map, size_t index, bool value)
+{
+    if (value) { map[index / 32] |= (uint32_t)1 << (index % 32); }
+    else { map[index / 32] &= ~((uint32_t)1 << (index % 32)); }
+}
+
+static size_t granules(struct sspi_psram const *psram)
+{
+    size_t const count = psram->size / psram->granule_size;
+    return (count < SSPI_PSRAM_GRANULES_MAX) ? count : SSPI_PSRAM_GRANULES_MAX;
+}
+
+/* Burst transfer split on page boundaries: the device wraps the address within a page */
+static bool psram_transfer(struct sspi_psram const *psram,
+                           uint32_t addr,
+                           uint8_t *read_buff,
+                           uint8_t const *write_buff,
+                           size_t size)
+{
+    bool done = true;
+
+    while (done && size)
+    {
+        size_t const page_left = psram->page_size - addr % psram->page_size;
+        size_t const chunk = (size < page_left) ? size : page_left;
+        uint8_t const header[] = {
+            write_buff ? SSPI_PSRAM_CMD_WRITE : SSPI_PSRAM_CMD_READ,
+            (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr,
+        };
+
+        sspi_select(psram->bus, true);
+        done = sspi_write(psram->bus, header, sizeof(header)) &&
+               sspi_read_write(psram->bus, read_buff, write_buff, chunk);
+        sspi_select(psram->bus, false);
+
+        addr += (uint32_t)chunk;
+        size -= chunk;
+        if (read_buff) { read_buff += chunk; }
+        if (write_buff) { write_buff += chunk; }
+    }
+    return done;
+}
+
+/* Get the line caching the address. On a miss the least recently used line is replaced:
+ * it is written back if modified and filled from the device unless 'fill' is false.
+ * */
+static struct sspi_psram_line *psram_line(struct sspi_psram *psram, uint32_t addr, bool fill)
+{
+    uint32_t const line_addr = addr - addr % SSPI_PSRAM_LINE_SIZE;
+    struct sspi_psram_line *victim = &psram->lines[0];
+
+    psram->clock++;
+    for (size_t i = 0; i < SSPI_PSRAM_LINES; i++)
+    {
+        struct sspi_psram_line *const line = &psram->lines[i];
+        if (line->addr == line_addr)
+        {
+            psram->hits++;
+            line->stamp = psram->clock;
+            return line;
+        }
+        if (line->addr == SSPI_PSRAM_NULL || (victim->addr != SSPI_PSRAM_NULL && line->stamp < victim->stamp))
+        {
+            victim = line;
+        }
+    }
+
+    psram->misses++;
+    if (victim->dirty && !psram_transfer(psram, victim->addr, NULL, victim->data, SSPI_PSRAM_LINE_SIZE)) { return NULL; }
+
+    victim->addr = SSPI_PSRAM_NULL;
+    victim->dirty = false;
+    if (fill && !psram_transfer(psram, line_addr, victim->data, NULL, SSPI_PSRAM_LINE_SIZE)) { return NULL; }
+
+    victim->addr = line_addr;
+    victim->stamp = psram->clock;
+    return victim;
+}
+
+void sspi_psram_init(struct sspi_psram *psram)
+{
+    for (size_t i = 0; i < SSPI_PSRAM_GRANULES_MAX / 32; i++)
+    {
+        psram->used[i] = 0;
+        psram->last[i] = 0;
+    }
+    for (size_t i = 0; i < SSPI_PSRAM_LINES; i++)
+    {
+        psram->lines[i].addr = SSPI_PSRAM_NULL;
+        psram->lines[i].dirty = false;
+    }
+    psram->clock = 0;
+    psram->hits = 0;
+    psram->misses = 0;
+}
+
+uint32_t sspi_psram_alloc(struct sspi_psram *psram, size_t size)
+{
+    size_t const count = size ? (size + psram->granule_size - 1) / psram->granule_size : 1;
+    size_t const total = granules(psram);
+    size_t run = 0;
+
+    for (size_t i = 0; i < total; i++)
+    {
+        run = bit_get(psram->used, i) ? 0 : run + 1;
+        if (run == count)
+        {
+            size_t const first = i + 1 - count;
+            for (size_t j = first; j <= i; j++) { bit_set(psram->used, j, true); }
+            bit_set(psram->last, i, true);
+            return (uint32_t)(first * psram->granule_size);
+        }
+    }
+    return SSPI_PSRAM_NULL;
+}
+
+void sspi_psram_free(struct sspi_psram *psram, uint32_t addr)
+{
+    size_t const total = granules(psram);
+
+    if (addr == SSPI_PSRAM_NULL) { return; }
+
+    for (size_t i = addr / psram->granule_size; i < total && bit_get(psram->used, i); i++)
+    {
+        bool const last = bit_get(psram->last, i);
+        bit_set(psram->used, i, false);
+        bit_set(psram->last, i, false);
+        if (last) { break; }
+    }
+}
+
+bool sspi_psram_read(struct sspi_psram *psram, uint32_t addr, uint8_t *buff, size_t size)
+{
+    while (size)
+    {
+        struct sspi_psram_line *const line = psram_line(psram, addr, true);
+        size_t const offset = addr % SSPI_PSRAM_LINE_SIZE;
+        size_t const chunk = (size < SSPI_PSRAM_LINE_SIZE - offset) ? size : SSPI_PSRAM_LINE_SIZE - offset;
+
+        if (!line) { return false; }
+        for (size_t i = 0; i < chunk; i++) { buff[i] = line->data[offset + i]; }
+
+        addr += (uint32_t)chunk;
+        buff += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool sspi_psram_write(struct sspi_psram *psram, uint32_t addr, uint8_t const *data, size_t size)
+{
+    while (size)
+    {
+        size_t const offset = addr % SSPI_PSRAM_LINE_SIZE;
+        size_t const chunk = (size < SSPI_PSRAM_LINE_SIZE - offset) ? size : SSPI_PSRAM_LINE_SIZE - offset;
+        /* Whole lines are overwritten without reading them */
+        struct sspi_psram_line *const line = psram_line(psram, addr, chunk < SSPI_PSRAM_LINE_SIZE);
+
+        if (!line) { return false; }
+        for (size_t i = 0; i < chunk; i++) { line->data[offset + i] = data[i]; }
+        line->dirty = true;
+
+        addr += (uint32_t)chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool sspi_psram_flush(struct sspi_psram *psram)
+{
+    for (size_t i = 0; i < SSPI_PSRAM_LINES; i++)
+    {
+        struct sspi_psram_line *const line = &psram->lines[i];
+        if (!line->dirty) { continue; }
+        if (!psram_transfer(psram, line->addr, NULL, line->data, SSPI_PSRAM_LINE_SIZE)) { return false; }
+        line->dirty = false;
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * SPI PSRAM driver with a memory pool and a write-back cache
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_PSRAM_H
+#define SOFTBUS_SSPI_PSRAM_H
+
+#include "sspi.h"
+
+/* SPI PSRAM commands */
+#define SSPI_PSRAM_CMD_READ 0x03
+#define SSPI_PSRAM_CMD_WRITE 0x02
+
+/* Address returned when allocation fails */
+#define SSPI_PSRAM_NULL UINT32_MAX
+
+/* Cache line size in bytes: must divide the device page size */
+#ifndef SSPI_PSRAM_LINE_SIZE
+#define SSPI_PSRAM_LINE_SIZE 32
+#endif
+
+/* Number of cache lines */
+#ifndef SSPI_PSRAM_LINES
+#define SSPI_PSRAM_LINES 4
+#endif
+
+/* Maximum number of allocation granules */
+#ifndef SSPI_PSRAM_GRANULES_MAX
+#define SSPI_PSRAM_GRANULES_MAX 256
+#endif
+
+/* Cache line: a copy of the aligned device block */
+struct sspi_psram_line
+{
+    /* Device address of the line, SSPI_PSRAM_NULL if the line is empty */
+    uint32_t addr;
+    /* Time of the last access for LRU replacement */
+    uint32_t stamp;
+    /* Line was modified and must be written back */
+    bool dirty;
+    uint8_t data[SSPI_PSRAM_LINE_SIZE];
+};
+
+/* SPI PSRAM (e.g. APS6404) with 24-bit addressing.
+ * Accesses go through a fully associative write-back cache in internal RAM: small random accesses
+ * hit the cache, misses move whole lines with burst transfers. Call sspi_psram_init() before use.
+ * */
+struct sspi_psram
+{
+    /* Bus connected to the device. The 'write_cs' callback is required. */
+    struct sspi const *bus;
+    /* Device size in bytes */
+    uint32_t size;
+    /* Burst wrap boundary in bytes (1024 for APS6404) */
+    size_t page_size;
+    /* Allocation unit in bytes. The device is split into at most SSPI_PSRAM_GRANULES_MAX granules. */
+    size_t granule_size;
+
+    /* Allocated granules: one bit per granule */
+    uint32_t used[SSPI_PSRAM_GRANULES_MAX / 32];
+    /* Last granules of allocated blocks */
+    uint32_t last[SSPI_PSRAM_GRANULES_MAX / 32];
+    struct sspi_psram_line lines[SSPI_PSRAM_LINES];
+    uint32_t clock;
+    /* Cache statistics */
+    unsigned long hits;
+    unsigned long misses;
+};
+
+/* Free the whole pool and empty the cache without writing it back */
+void sspi_psram_init(struct sspi_psram *psram);
+
+/* Allocate a block of consecutive granules (first fit). Returns SSPI_PSRAM_NULL if there is no room. */
+uint32_t sspi_psram_alloc(struct sspi_psram *psram, size_t size);
+
+/* Free the block returned by sspi_psram_alloc() */
+void sspi_psram_free(struct sspi_psram *psram, uint32_t addr);
+
+/* Read data array through the cache */
+bool sspi_psram_read(struct sspi_psram *psram, uint32_t addr, uint8_t *buff, size_t size);
+
+/* Write data array to the cache. Partial lines are filled from the device first. */
+bool sspi_psram_write(struct sspi_psram *psram, uint32_t addr, uint8_t const *data, size_t size);
+
+/* Write all modified lines back to the device */
+bool sspi_psram_flush(struct sspi_psram *psram);
+
+#endif /* SOFTBUS_SSPI_PSRAM_H */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Register reads coalesced into bursts by bus cost
+ * 
+ */
+
+#include "sspi_regs.h"
+
+/* Check if the gap between two registers may be read and discarded */
+static bool gap_readable(struct sspi_regs const *regs, uint8_t prev, uint8_t next)
+{
+    if (!regs->is_read_sensitive) { return true; }
+
+    for (unsigned addr = prev + 1u; addr < next; addr++)
+    {
+        if (regs->is_read_sensitive(regs, (uint8_t)addr)) { return false; }
+    }
+    return true;
+}
+
+/* Index past the last register of the burst starting at 'first'.
+ * Every gap costs the same whatever the other gaps are, so merging each gap that is cheaper
+ * than a new transaction gives the cheapest plan.
+ * */
+static size_t burst_end(struct sspi_regs const *regs, uint8_t const *addrs, size_t count, size_t first)
+{
+    size_t end = first + 1;
+
+    while (end < count)
+    {
+        unsigned long const gap = (unsigned long)(addrs[end] - addrs[end - 1] - 1);
+        if (gap * regs->byte_cost >= regs->transaction_cost) { break; }
+        if (addrs[end] - addrs[first] + 1 > SSPI_REGS_BURST_MAX) { break; }
+        if (!gap_readable(regs, addrs[end - 1], addrs[end])) { break; }
+        end++;
+    }
+    return end;
+}
+
+unsigned long sspi_regs_cost(struct sspi_regs const *regs,
+                             uint8_t const *addrs,
+                             size_t count,
+                             size_t *transactions)
+{
+    unsigned long cost = 0;
+    size_t bursts = 0;
+
+    for (size_t first = 0; first < count; bursts++)
+    {
+        size_t const end = burst_end(regs, addrs, count, first);
+        cost += regs->transaction_cost + (unsigned long)(addrs[end - 1] - addrs[first] + 1) * regs->byte_cost;
+        first = end;
+    }
+
+    if (transactions) { *transactions = bursts; }
+    return cost;
+}
+
+bool sspi_regs_read(struct sspi_regs const *regs, uint8_t const *addrs, uint8_t *values, size_t count)
+{
+    bool done = true;
+
+    for (size_t first = 0; done && first < count;)
+    {
+        size_t const end = burst_end(regs, addrs, count, first);
+        size_t const span = (size_t)(addrs[end - 1] - addrs[first] + 1);
+        uint8_t buff[1 + SSPI_REGS_BURST_MAX] = {0};
+
+        /* Command and data share one transfer, the byte read during the command is dropped */
+        buff[0] = addrs[first] | regs->read_flag | ((end - first > 1) ? regs->burst_flag : 0);
+        sspi_select(regs->bus, true);
+        done = sspi_read_write(regs->bus, buff, buff, 1 + span);
+        sspi_select(regs->bus, false);
+
+        /* Gap bytes are dropped */
+        for (size_t i = first; done && i < end; i++) { values[i] = buff[1 + addrs[i] - addrs[first]]; }
+        first = end;
+    }
+    return done;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Register reads coalesced into bursts by bus cost
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_REGS_H
+#define SOFTBUS_SSPI_REGS_H
+
+#include "sspi.h"
+
+/* Longest burst in bytes including gap bytes. A burst is read into a stack buffer of this size
+ * with a single sspi_read_write() call, so handshake and framing settings apply once per transaction.
+ * */
+#ifndef SSPI_REGS_BURST_MAX
+#define SSPI_REGS_BURST_MAX 32
+#endif
+
+/* Device with byte-wide registers read by a command byte holding the register address.
+ * Scattered registers are read in auto-increment bursts when reading and discarding the gap bytes
+ * is cheaper than starting a new transaction.
+ * */
+struct sspi_regs
+{
+    /* Bus connected to the device. The 'write_cs' callback is required. */
+    struct sspi const *bus;
+    /* Bits set in the command byte of every read (e.g. 0x80) */
+    uint8_t read_flag;
+    /* Bits set in the command byte of multi-byte reads to enable address auto-increment (e.g. 0x40) */
+    uint8_t burst_flag;
+    /* Measured cost of a transaction without data: CS framing and the command byte.
+     * Any unit may be used (e.g. half periods or CPU cycles) as long as both costs use the same one.
+     * */
+    unsigned long transaction_cost;
+    /* Measured cost of one data byte */
+    unsigned long byte_cost;
+    /* Optional: returns true for registers that must not be read as gap bytes because reading them
+     * has side effects (e.g. clear-on-read status or FIFO data). May be NULL.
+     * */
+    bool (*is_read_sensitive)(struct sspi_regs const *regs, uint8_t addr);
+};
+
+/* Estimated cost of reading the registers. Addresses must be sorted in ascending order without duplicates.
+ * The number of transactions is stored to 'transactions' (may be NULL).
+ * */
+unsigned long sspi_regs_cost(struct sspi_regs const *regs,
+                             uint8_t const *addrs,
+                             size_t count,
+                             size_t *transactions);
+
+/* Read the registers: value of addrs[i] is stored to values[i].
+ * Addresses must be sorted in ascending order without duplicates.
+ * */
+bool sspi_regs_read(struct sspi_regs const *regs, uint8_t const *addrs, uint8_t *values, size_t count);
+
+#endif /* SOFTBUS_SSPI_REGS_H */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * SSI absolute encoder interface over Software SPI
+ * 
+ */
+
+#include "sspi_ssi.h"
+
+/* Clock in one bit: MOSI is not used by SSI */
+static inline uint32_t ssi_bit(struct sspi const *bus)
+{
+    return (sspi_bit_read_write(bus, SSPI_PIN_LOW) == SSPI_PIN_HIGH) ? 1 : 0;
+}
+
+bool sspi_ssi_read(struct sspi_ssi *enc)
+{
+    struct sspi const *const bus = enc->bus;
+    uint32_t raw = 0;
+    uint32_t status = 0;
+    uint32_t binary = 0;
+
+    for (int bit = 0; bit < enc->lead_bits; bit++) { ssi_bit(bus); }
+
+    for (int bit = 0; bit < enc->position_bits; bit++)
+    {
+        /* Gray to binary: every binary bit is the XOR of the previous binary bit and the Gray bit */
+        binary = enc->gray ? binary ^ ssi_bit(bus) : ssi_bit(bus);
+        raw = raw << 1 | binary;
+    }
+
+    for (int bit = 0; bit < enc->status_bits; bit++) { status = status << 1 | ssi_bit(bus); }
+
+    for (unsigned time = 0; time < enc->monoflop; time++) { bus->delay(bus); }
+
+    enc->status = status;
+    if (status & enc->error_mask) { return false; }
+
+    if (enc->valid)
+    {
+        /* Shortest signed distance in the position counter range */
+        uint64_t const range = (uint64_t)1 << enc->position_bits;
+        uint64_t const delta = ((uint64_t)raw - enc->raw) & (range - 1);
+        enc->position += (delta >= range / 2) ? (int64_t)delta - (int64_t)range : (int64_t)delta;
+    }
+    else
+    {
+        enc->position = raw;
+        enc->valid = true;
+    }
+
+    enc->raw = raw;
+    return true;
+}
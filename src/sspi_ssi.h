@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * SSI absolute encoder interface over Software SPI
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_SSI_H
+#define SOFTBUS_SSPI_SSI_H
+
+#include "sspi.h"
+
+/* SSI absolute encoder.
+ * A frame is a clock burst of 'lead_bits' + 'position_bits' + 'status_bits' bits (MSB first).
+ * Gray decoding, status extraction and unwrapping are done while the bits arrive.
+ * */
+struct sspi_ssi
+{
+    /* Bus connected to the encoder. Most encoders use CPOL 1 and CPHA 1. */
+    struct sspi const *bus;
+    /* Number of bits skipped before the position (e.g. the start bit) */
+    int lead_bits;
+    /* Number of position bits: 1-32 */
+    int position_bits;
+    /* Number of status bits following the position: 0-32 */
+    int status_bits;
+    /* Status bits that signal an error */
+    uint32_t error_mask;
+    /* Position is Gray coded */
+    bool gray;
+    /* Monoflop time in half periods: the clock is held idle after the frame */
+    unsigned monoflop;
+    /* Last position as read from the encoder */
+    uint32_t raw;
+    /* Last status bits */
+    uint32_t status;
+    /* Position unwrapped across the overflows of the position counter.
+     * The first successful read sets it to the raw position.
+     * */
+    int64_t position;
+    /* Set after the first successful read (false on start) */
+    bool valid;
+};
+
+/* Read the frame and update the position.
+ * Returns false if the status has error bits: the position is not updated in this case.
+ * */
+bool sspi_ssi_read(struct sspi_ssi *enc);
+
+#endif /* SOFTBUS_SSPI_SSI_H */
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Storage striped across SPI NOR flash chips on separate buses
+ * 
+ */
+
+#include "sspi_stripe.h"
+
+/* Chip address of the first byte at or after the logical address that lives on the chip */
+static uint32_t chip_addr(struct sspi_stripe const *stripe, size_t chip, uint32_t addr)
+{
+    uint32_t const row_size = (uint32_t)(stripe->stripe_size * stripe->count);
+    uint32_t const row = addr / row_size;
+    uint32_t const pos = addr % row_size;
+    uint32_t const start = (uint32_t)(chip * stripe->stripe_size);
+
+    if (pos < start) { return row * (uint32_t)stripe->stripe_size; }
+    if (pos < start + stripe->stripe_size) { return row * (uint32_t)stripe->stripe_size + pos - start; }
+    return (row + 1) * (uint32_t)stripe->stripe_size;
+}
+
+/* Logical address of the byte at the chip address */
+static uint32_t logical_addr(struct sspi_stripe const *stripe, size_t chip, uint32_t addr)
+{
+    uint32_t const unit = (uint32_t)stripe->stripe_size;
+    return (addr / unit) * unit * (uint32_t)stripe->count + (uint32_t)chip * unit + addr % unit;
+}
+
+/* Run the transfers on all buses at once */
+static void stripe_transfer(struct sspi_stripe const *stripe, struct sspi_transfer const *xfers)
+{
+    struct sspi const *buses[SSPI_STRIPE_CHIPS_MAX];
+
+    for (size_t i = 0; i < stripe->count; i++) { buses[i] = stripe->chips[i].bus; }
+    sspi_multi_read_write(buses, xfers, stripe->count);
+}
+
+/* Select the chips with set 'active' flags and send them a command with an optional 24-bit address.
+ * The chips are left selected.
+ * */
+static void stripe_command(struct sspi_stripe const *stripe,
+                           bool const *active,
+                           uint8_t cmd,
+                           bool with_addr,
+                           uint32_t const *addrs)
+{
+    uint8_t headers[SSPI_STRIPE_CHIPS_MAX][4];
+    struct sspi_transfer xfers[SSPI_STRIPE_CHIPS_MAX] = {0};
+
+    for (size_t i = 0; i < stripe->count; i++)
+    {
+        if (!active[i]) { continue; }
+
+        uint32_t const addr = with_addr ? addrs[i] : 0;
+        headers[i][0] = cmd;
+        headers[i][1] = (uint8_t)(addr >> 16);
+        headers[i][2] = (uint8_t)(addr >> 8);
+        headers[i][3] = (uint8_t)addr;
+        xfers[i].write_buff = headers[i];
+        xfers[i].size = with_addr ? sizeof(headers[i]) : 1;
+        sspi_select(stripe->chips[i].bus, true);
+    }
+    stripe_transfer(stripe, xfers);
+}
+
+/* Deselect the chips with set 'active' flags */
+static void stripe_deselect(struct sspi_stripe const *stripe, bool const *active)
+{
+    for (size_t i = 0; i < stripe->count; i++)
+    {
+        if (active[i]) { sspi_select(stripe->chips[i].bus, false); }
+    }
+}
+
+/* Wait for every chip with set 'active' flag. The chips work in parallel, so the total time
+ * is that of the slowest one.
+ * */
+static bool stripe_wait(struct sspi_stripe const *stripe, bool const *active)
+{
+    bool done = true;
+
+    for (size_t i = 0; i < stripe->count; i++)
+    {
+        if (active[i] && !sspi_flash_wait(&stripe->chips[i])) { done = false; }
+    }
+    return done;
+}
+
+bool sspi_stripe_read(struct sspi_stripe const *stripe, uint32_t addr, uint8_t *buff, size_t size)
+{
+    uint32_t const row_size = (uint32_t)(stripe->stripe_size * stripe->count);
+    uint32_t const end = addr + (uint32_t)size;
+    uint32_t addrs[SSPI_STRIPE_CHIPS_MAX];
+    bool active[SSPI_STRIPE_CHIPS_MAX];
+
+    if (size == 0) { return true; }
+
+    for (size_t i = 0; i < stripe->count; i++)
+    {
+        addrs[i] = chip_addr(stripe, i, addr);
+        active[i] = addrs[i] < chip_addr(stripe, i, end);
+    }
+
+    /* Every chip streams its part continuously, one row of stripe units per transfer */
+    stripe_command(stripe, active, SSPI_FLASH_CMD_READ, true, addrs);
+    for (uint32_t row = addr - addr % row_size; row < end; row += row_size)
+    {
+        struct sspi_transfer xfers[SSPI_STRIPE_CHIPS_MAX] = {0};
+
+        for (size_t i = 0; i < stripe->count; i++)
+        {
+            uint32_t const unit = row + (uint32_t)(i * stripe->stripe_size);
+            uint32_t const first = (unit > addr) ? unit : addr;
+            uint32_t const last = (unit + stripe->stripe_size < end) ? unit + (uint32_t)stripe->stripe_size : end;
+
+            if (first < last)
+            {
+                xfers[i].read_buff = buff + (first - addr);
+                xfers[i].size = last - first;
+            }
+        }
+        stripe_transfer(stripe, xfers);
+    }
+    stripe_deselect(stripe, active);
+    return true;
+}
+
+bool sspi_stripe_erase(struct sspi_stripe const *stripe, uint32_t addr, size_t size)
+{
+    uint32_t addrs[SSPI_STRIPE_CHIPS_MAX];
+    uint32_t ends[SSPI_STRIPE_CHIPS_MAX];
+    bool active[SSPI_STRIPE_CHIPS_MAX];
+    bool done = true;
+    bool more = true;
+
+    for (size_t i = 0; i < stripe->count; i++)
+    {
+        uint32_t const first = chip_addr(stripe, i, addr);
+        ends[i] = chip_addr(stripe, i, addr + (uint32_t)size);
+        /* Chips the range does not touch keep all their sectors */
+        addrs[i] = (first < ends[i]) ? first - first % (uint32_t)stripe->chips[i].sector_size : ends[i];
+    }
+
+    /* Erase a sector on every chip at once */
+    while (done && more)
+    {
+        more = false;
+        for (size_t i = 0; i < stripe->count; i++)
+        {
+            active[i] = addrs[i] < ends[i];
+            more = more || active[i];
+        }
+        if (!more) { break; }
+
+        stripe_command(stripe, active, SSPI_FLASH_CMD_WRITE_ENABLE, false, NULL);
+        stripe_deselect(stripe, active);
+        stripe_command(stripe, active, SSPI_FLASH_CMD_SECTOR_ERASE, true, addrs);
+        stripe_deselect(stripe, active);
+        done = stripe_wait(stripe, active);
+
+        for (size_t i = 0; i < stripe->count; i++)
+        {
+            if (active[i]) { addrs[i] += (uint32_t)stripe->chips[i].sector_size; }
+        }
+    }
+    return done;
+}
+
+bool sspi_stripe_program(struct sspi_stripe const *stripe, uint32_t addr, uint8_t const *data, size_t size)
+{
+    uint32_t addrs[SSPI_STRIPE_CHIPS_MAX];
+    uint32_t ends[SSPI_STRIPE_CHIPS_MAX];
+    bool active[SSPI_STRIPE_CHIPS_MAX];
+    bool done = true;
+    bool more = true;
+
+    for (size_t i = 0; i < stripe->count; i++)
+    {
+        addrs[i] = chip_addr(stripe, i, addr);
+        ends[i] = chip_addr(stripe, i, addr + (uint32_t)size);
+    }
+
+    /* Program a page on every chip at once. A page never crosses a stripe unit,
+     * so its data is contiguous in the logical array.
+     * */
+    while (done && more)
+    {
+        struct sspi_transfer xfers[SSPI_STRIPE_CHIPS_MAX] = {0};
+
+        more = false;
+        for (size_t i = 0; i < stripe->count; i++)
+        {
+            size_t const page_size = stripe->chips[i].page_size;
+            size_t const page_left = page_size - addrs[i] % page_size;
+
+            active[i] = addrs[i] < ends[i];
+            more = more || active[i];
+            if (active[i])
+            {
+                xfers[i].write_buff = data + (logical_addr(stripe, i, addrs[i]) - addr);
+                xfers[i].size = (ends[i] - addrs[i] < page_left) ? ends[i] - addrs[i] : page_left;
+            }
+        }
+        if (!more) { break; }
+
+        stripe_command(stripe, active, SSPI_FLASH_CMD_WRITE_ENABLE, false, NULL);
+        stripe_deselect(stripe, active);
+        stripe_command(stripe, active, SSPI_FLASH_CMD_PAGE_PROGRAM, true, addrs);
+        stripe_transfer(stripe, xfers);
+        stripe_deselect(stripe, active);
+        done = stripe_wait(stripe, active);
+
+        for (size_t i = 0; i < stripe->count; i++) { addrs[i] += (uint32_t)xfers[i].size; }
+    }
+    return done;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Storage striped across SPI NOR flash chips on separate buses
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_STRIPE_H
+#define SOFTBUS_SSPI_STRIPE_H
+
+#include "sspi_flash.h"
+
+/* Maximum number of chips in a stripe set */
+#define SSPI_STRIPE_CHIPS_MAX 8
+
+/* Flash chips with independent buses joined into one address space (RAID 0).
+ * Consecutive stripe units go to consecutive chips: logical address A lives on chip
+ * (A / stripe_size) % count at address (A / (stripe_size * count)) * stripe_size + A % stripe_size.
+ * All buses are clocked together by sspi_multi_read_write(), so reads and programs
+ * spanning several chips move a byte per chip in the time of one byte.
+ * */
+struct sspi_stripe
+{
+    /* Chips with identical geometry and bus timing. Only the delay of the first bus is used. */
+    struct sspi_flash const *chips;
+    /* Number of chips: 1-SSPI_STRIPE_CHIPS_MAX */
+    size_t count;
+    /* Stripe unit in bytes: a multiple of the page size */
+    size_t stripe_size;
+};
+
+/* Read data array */
+bool sspi_stripe_read(struct sspi_stripe const *stripe, uint32_t addr, uint8_t *buff, size_t size);
+
+/* Erase every sector touched by the range on every chip.
+ * Align the range to sector_size * count to avoid erasing data outside of it.
+ * */
+bool sspi_stripe_erase(struct sspi_stripe const *stripe, uint32_t addr, size_t size);
+
+/* Program data array. The area must be erased. Chips are programmed a page at a time in parallel. */
+bool sspi_stripe_program(struct sspi_stripe const *stripe, uint32_t addr, uint8_t const *data, size_t size);
+
+#endif /* SOFTBUS_SSPI_STRIPE_H */
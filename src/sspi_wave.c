@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Precomputed waveform tables for Software SPI
+ * 
+ */
+
+#include "sspi_wave.h"
+
+void sspi_wave_play(struct sspi const *bus, uint8_t const *wave, size_t size)
+{
+    uint8_t state = SSPI_WAVE_IDLE(bus->cpol_1);
+
+    while (size--)
+    {
+        uint8_t const changed = state ^ *wave;
+        state = *wave++;
+
+        /* SCK goes first: MOSI changes right after the edge in both phases */
+        if (changed & SSPI_WAVE_SCK) { bus->write_sck(bus, (state & SSPI_WAVE_SCK) ? SSPI_PIN_HIGH : SSPI_PIN_LOW); }
+        if (changed & SSPI_WAVE_MOSI) { bus->write_mosi(bus, (state & SSPI_WAVE_MOSI) ? SSPI_PIN_HIGH : SSPI_PIN_LOW); }
+        bus->delay(bus);
+    }
+
+    /* Return to the default state: in CPHA 0 the last bit ends with SCK in the active state */
+    if ((state & SSPI_WAVE_SCK) ? !bus->cpol_1 : bus->cpol_1)
+    {
+        bus->write_sck(bus, bus->cpol_1 ? SSPI_PIN_HIGH : SSPI_PIN_LOW);
+    }
+    if (state & SSPI_WAVE_MOSI) { bus->write_mosi(bus, SSPI_PIN_LOW); }
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Precomputed waveform tables for Software SPI
+ * 
+ */
+
+#ifndef SOFTBUS_SSPI_WAVE_H
+#define SOFTBUS_SSPI_WAVE_H
+
+#include "sspi.h"
+
+/* Waveform tables turn constant command sequences into port states at compile time.
+ * Every table entry holds SCK and MOSI levels for one half period. All macros expand to
+ * constant expressions, so tables may be declared 'static const' and stored in flash:
+ *
+ *     static uint8_t const init_wave[] = {
+ *         SSPI_WAVE_BYTE(0, 0, 0, 0x9F),
+ *         SSPI_WAVE_BYTE(0, 0, 0, 0x00),
+ *     };
+ *     sspi_wave_play(&bus, init_wave, sizeof(init_wave));
+ *
+ * The same table may be mapped to port set/reset words and sent with DMA where available.
+ * */
+
+/* Bits of the port state */
+#define SSPI_WAVE_SCK 0x01
+#define SSPI_WAVE_MOSI 0x02
+
+/* Port state with given SCK and MOSI levels */
+#define SSPI_WAVE_STATE(sck, mosi) ((uint8_t)(((sck) ? SSPI_WAVE_SCK : 0) | ((mosi) ? SSPI_WAVE_MOSI : 0)))
+
+/* Idle state: SCK matches CPOL, MOSI is low */
+#define SSPI_WAVE_IDLE(cpol) SSPI_WAVE_STATE(cpol, 0)
+
+/* Two half periods of one bit.
+ * CPHA 0: MOSI changes with the trailing edge, the slave samples on the leading edge.
+ * CPHA 1: MOSI changes with the leading edge, the slave samples on the trailing edge.
+ * */
+#define SSPI_WAVE_BIT(cpol, cpha, bit)                           \
+    SSPI_WAVE_STATE((cpha) ? !(cpol) : (cpol), (bit) & 0x01), \
+        SSPI_WAVE_STATE((cpha) ? (cpol) : !(cpol), (bit) & 0x01)
+
+/* Bit number 'n' of the byte in transmission order */
+#define SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, n) \
+    SSPI_WAVE_BIT(cpol, cpha, (byte) >> ((lsb) ? (n) : 7 - (n)))
+
+/* Sixteen half periods of one byte */
+#define SSPI_WAVE_BYTE(cpol, cpha, lsb, byte)                                                         \
+    SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 0), SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 1),     \
+        SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 2), SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 3), \
+        SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 4), SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 5), \
+        SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 6), SSPI_WAVE_BYTE_BIT(cpol, cpha, lsb, byte, 7)
+
+/* Play the waveform table: every state is held for one half period and only changed pins are
+ * written. The bus must be in the default state (see sspi_reset()). MISO is not read.
+ * After the last entry SCK and MOSI are returned to the default state, like after sspi_write(),
+ * so tables do not need a trailing SSPI_WAVE_IDLE() entry.
+ * */
+void sspi_wave_play(struct sspi const *bus, uint8_t const *wave, size_t size);
+
+#endif /* SOFTBUS_SSPI_WAVE_H */
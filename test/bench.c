@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020 Oleg Dolgy
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * Benchmark of the Software SPI transfer kernels
+ * 
+ */
+
+#include "sspi.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/* Time source. On a target define BENCH_TIME() as the cycle counter (e.g. DWT->CYCCNT)
+ * and BENCH_UNIT as "cycles" to get cycles per bit. */
+#ifndef BENCH_TIME
+#define BENCH_TIME() bench_time_ns()
+#define BENCH_UNIT "ns"
+
+static unsigned long long bench_time_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+#endif
+
+/* Number of bytes per measurement */
+#ifndef BENCH_BYTES
+#define BENCH_BYTES 4096
+#endif
+
+/*------------------------------------------------------------------------------------------------*/
+/* Port emulation: the cheapest possible pin access */
+/*------------------------------------------------------------------------------------------------*/
+static volatile sspi_pin_state_t port_sck, port_mosi, port_miso;
+
+static void write_sck(struct sspi const *bus, sspi_pin_state_t state)
+{
+    port_sck = state;
+}
+
+static void write_mosi(struct sspi const *bus, sspi_pin_state_t state)
+{
+    port_mosi = state;
+    port_miso = state; /* Loopback */
+}
+
+static sspi_pin_state_t read_miso(struct sspi const *bus)
+{
+    return port_miso;
+}
+
+static void delay(struct sspi const *bus)
+{
+}
+/*------------------------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------------------------*/
+static uint8_t tx_buff[BENCH_BYTES], rx_buff[BENCH_BYTES];
+
+static void bench(char const *name, struct sspi const *bus, bool dtr)
+{
+    unsigned long long const start = BENCH_TIME();
+    if (dtr) { sspi_dtr_read_write(bus, rx_buff, tx_buff, sizeof(tx_buff)); }
+    else { sspi_read_write(bus, rx_buff, tx_buff, sizeof(tx_buff)); }
+    unsigned long long const time = BENCH_TIME() - start;
+
+    printf("%-10s %8.2f %s/bit\n", name, (double)time / (8.0 * sizeof(tx_buff)), BENCH_UNIT);
+}
+
+int main(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+    };
+
+    for (size_t i = 0; i < sizeof(tx_buff); i++) { tx_buff[i] = (uint8_t)i; }
+
+#ifdef SSPI_HOT_SECTION
+    printf("Kernels placed in section %s\n", SSPI_HOT_SECTION);
+#else
+    printf("Kernels placed in the default section\n");
+#endif
+    bench("SDR", &sspi, false);
+    bench("DTR", &sspi, true);
+    return 0;
+}
+/*------------------------------------------------------------------------------------------------*/
@@ -24,6 +24,17 @@
  */
 
 #include "sspi.h"
+#include "sspi_acq.h"
+#include "sspi_flash.h"
+#include "sspi_gang.h"
+#include "sspi_microwire.h"
+#include "sspi_heatshrink.h"
+#include "sspi_pool.h"
+#include "sspi_psram.h"
+#include "sspi_regs.h"
+#include "sspi_ssi.h"
+#include "sspi_stripe.h"
+#include "sspi_wave.h"
 #include "unity.h"
 
 #include <stdio.h>
@@ -115,7 +126,7 @@ static void gpio_pin_sample(struct gpio_pin *pin)
 /*------------------------------------------------------------------------------------------------*/
 /* Software SPI implementation */
 /*------------------------------------------------------------------------------------------------*/
-static struct gpio_pin pin_sck, pin_miso, pin_mosi;
+static struct gpio_pin pin_sck, pin_miso, pin_mosi, pin_cs;
 
 static void write_sck(struct sspi const *bus, sspi_pin_state_t state)
 {
@@ -127,16 +138,464 @@ static void write_mosi(struct sspi const *bus, sspi_pin_state_t state)
     gpio_pin_write(&pin_mosi, state);
 }
 
+static void write_cs(struct sspi const *bus, bool select)
+{
+    gpio_pin_write(&pin_cs, select ? SSPI_PIN_LOW : SSPI_PIN_HIGH);
+}
+
 static sspi_pin_state_t read_miso(struct sspi const *bus)
 {
     return gpio_pin_read(&pin_miso);
 }
 
+/* MISO read with a glitch on every third call */
+static int miso_reads;
+
+static sspi_pin_state_t read_miso_glitchy(struct sspi const *bus)
+{
+    sspi_pin_state_t const state = gpio_pin_read(&pin_miso);
+    if (++miso_reads % 3) { return state; }
+    return (state == SSPI_PIN_HIGH) ? SSPI_PIN_LOW : SSPI_PIN_HIGH;
+}
+
+/* Batched MISO read: one port read per bit, the last of the samples is a glitch */
+static int miso_vote_batches;
+
+static int read_miso_votes_glitchy(struct sspi const *bus, int count)
+{
+    bool const high = gpio_pin_read(&pin_miso) == SSPI_PIN_HIGH;
+    miso_vote_batches++;
+    return high ? count - 1 : 1;
+}
+
+/* Ready line states returned on successive polls: '^' - ready, '_' - busy */
+static char const *ready_polls;
+
+static bool is_ready(struct sspi const *bus)
+{
+    if (!*ready_polls) { return true; }
+    return *ready_polls++ == '^';
+}
+
 static void delay(struct sspi const *bus)
 {
     gpio_pin_sample(&pin_sck);
     gpio_pin_sample(&pin_mosi);
     gpio_pin_sample(&pin_miso);
+    gpio_pin_sample(&pin_cs);
+}
+/*------------------------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------------------------*/
+/* Byte-level SPI slave emulation (mode 0, MSB): the base of the device models below */
+/*------------------------------------------------------------------------------------------------*/
+struct spi_slave
+{
+    struct sspi bus; /* Must be the first member */
+    /* Handle the byte received at the index of the transaction, 'out_byte' is sent next */
+    void (*on_byte)(struct spi_slave *slave, uint8_t byte, size_t index);
+    /* Optional: handle deselect after 'byte_index' bytes */
+    void (*on_deselect)(struct spi_slave *slave);
+    /* Empty socket: SCK is ignored and floating MISO is pulled up */
+    bool absent;
+    bool sck, mosi, miso;
+    size_t byte_index;
+    int bit;
+    uint8_t in_byte;
+    uint8_t out_byte;
+    unsigned long half_periods;
+    unsigned transactions;
+    unsigned bytes;
+};
+
+static struct spi_slave *spi_slave_get(struct sspi const *bus)
+{
+    return (struct spi_slave *)bus;
+}
+
+/* MOSI is shifted in on the rising edge, MISO is shifted out on the falling edge */
+static void spi_slave_write_sck(struct sspi const *bus, sspi_pin_state_t state)
+{
+    struct spi_slave *const slave = spi_slave_get(bus);
+    bool const rising = !slave->sck && state == SSPI_PIN_HIGH;
+    bool const falling = slave->sck && state == SSPI_PIN_LOW;
+    slave->sck = state == SSPI_PIN_HIGH;
+    if (slave->absent) { return; }
+
+    if (rising)
+    {
+        slave->in_byte = slave->in_byte << 1 | (slave->mosi ? 1 : 0);
+        if (++slave->bit == 8)
+        {
+            slave->bit = 0;
+            slave->bytes++;
+            slave->on_byte(slave, slave->in_byte, slave->byte_index++);
+        }
+    }
+    if (falling) { slave->miso = (slave->out_byte << slave->bit) & 0x80; }
+}
+
+static void spi_slave_write_mosi(struct sspi const *bus, sspi_pin_state_t state)
+{
+    spi_slave_get(bus)->mosi = state == SSPI_PIN_HIGH;
+}
+
+static sspi_pin_state_t spi_slave_read_miso(struct sspi const *bus)
+{
+    struct spi_slave *const slave = spi_slave_get(bus);
+    return (slave->absent || slave->miso) ? SSPI_PIN_HIGH : SSPI_PIN_LOW;
+}
+
+static void spi_slave_delay(struct sspi const *bus)
+{
+    spi_slave_get(bus)->half_periods++;
+}
+
+static void spi_slave_write_cs(struct sspi const *bus, bool select)
+{
+    struct spi_slave *const slave = spi_slave_get(bus);
+
+    if (select)
+    {
+        slave->byte_index = 0;
+        slave->bit = 0;
+        slave->out_byte = 0xFF;
+        slave->miso = true;
+        slave->transactions++;
+        return;
+    }
+    if (slave->on_deselect) { slave->on_deselect(slave); }
+}
+
+/* Slave with its own bus */
+static void spi_slave_init(struct spi_slave *slave,
+                           void (*on_byte)(struct spi_slave *, uint8_t, size_t),
+                           void (*on_deselect)(struct spi_slave *))
+{
+    *slave = (struct spi_slave){
+        .bus = {
+            .write_sck = spi_slave_write_sck,
+            .write_mosi = spi_slave_write_mosi,
+            .read_miso = spi_slave_read_miso,
+            .delay = spi_slave_delay,
+            .write_cs = spi_slave_write_cs,
+        },
+        .on_byte = on_byte,
+        .on_deselect = on_deselect,
+    };
+}
+/*------------------------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------------------------*/
+/* SPI NOR flash emulation */
+/*------------------------------------------------------------------------------------------------*/
+#define FLASH_PAGE_SIZE 16
+#define FLASH_SECTOR_SIZE 64
+#define FLASH_SIZE 256
+#define FLASH_BUSY_POLLS 2
+
+struct flash_chip
+{
+    struct spi_slave slave; /* Must be the first member */
+    uint8_t memory[FLASH_SIZE];
+    bool write_enabled;
+    bool write_protected;
+    int busy;
+    uint8_t cmd;
+    uint32_t addr;
+    unsigned erases;
+    unsigned programs;
+};
+
+static uint8_t flash_chip_status(struct flash_chip *chip)
+{
+    uint8_t const status = (chip->busy ? SSPI_FLASH_STATUS_BUSY : 0) | (chip->write_enabled ? 0x02 : 0);
+    if (chip->busy) { chip->busy--; }
+    return status;
+}
+
+static void flash_chip_byte(struct spi_slave *slave, uint8_t byte, size_t index)
+{
+    struct flash_chip *const chip = (struct flash_chip *)slave;
+    if (!index) { chip->cmd = byte; }
+    if (index >= 1 && index <= 3) { chip->addr = (chip->addr << 8 | byte) % FLASH_SIZE; }
+
+    switch (chip->cmd)
+    {
+    case SSPI_FLASH_CMD_READ_STATUS:
+        slave->out_byte = flash_chip_status(chip);
+        break;
+    case SSPI_FLASH_CMD_READ:
+        if (index >= 3) { slave->out_byte = chip->memory[chip->addr++ % FLASH_SIZE]; }
+        break;
+    case SSPI_FLASH_CMD_PAGE_PROGRAM:
+        if (index >= 4 && chip->write_enabled && !chip->busy)
+        {
+            /* Address wraps within the page, programming clears bits only */
+            uint32_t const page = chip->addr - chip->addr % FLASH_PAGE_SIZE;
+            chip->memory[page + (chip->addr + index - 4) % FLASH_PAGE_SIZE] &= byte;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* Operations start on deselect */
+static void flash_chip_deselect(struct spi_slave *slave)
+{
+    struct flash_chip *const chip = (struct flash_chip *)slave;
+    bool const enabled = chip->write_enabled && !chip->busy;
+
+    if (chip->cmd == SSPI_FLASH_CMD_WRITE_ENABLE && slave->byte_index == 1) { chip->write_enabled = !chip->write_protected; }
+    if (chip->cmd == SSPI_FLASH_CMD_PAGE_PROGRAM && slave->byte_index > 4 && enabled)
+    {
+        chip->programs++;
+        chip->busy = FLASH_BUSY_POLLS;
+        chip->write_enabled = false;
+    }
+    if (chip->cmd == SSPI_FLASH_CMD_SECTOR_ERASE && slave->byte_index == 4 && enabled)
+    {
+        memset(chip->memory + chip->addr - chip->addr % FLASH_SECTOR_SIZE, 0xFF, FLASH_SECTOR_SIZE);
+        chip->erases++;
+        chip->busy = FLASH_BUSY_POLLS;
+        chip->write_enabled = false;
+    }
+}
+
+/* Erased flash chip with its own bus */
+static void flash_chip_init(struct flash_chip *chip)
+{
+    *chip = (struct flash_chip){0};
+    spi_slave_init(&chip->slave, flash_chip_byte, flash_chip_deselect);
+    memset(chip->memory, 0xFF, sizeof(chip->memory));
+}
+
+/* Flash chips with shared SCK, CS and MOSI */
+#define GANG_LANES 3
+static struct flash_chip gang_chips[GANG_LANES];
+
+static void gang_write_sck(struct sspi const *bus, sspi_pin_state_t state)
+{
+    for (int lane = 0; lane < GANG_LANES; lane++) { spi_slave_write_sck(&gang_chips[lane].slave.bus, state); }
+}
+
+static void gang_write_mosi(struct sspi const *bus, sspi_pin_state_t state)
+{
+    for (int lane = 0; lane < GANG_LANES; lane++) { spi_slave_write_mosi(&gang_chips[lane].slave.bus, state); }
+}
+
+static void gang_write_cs(struct sspi const *bus, bool select)
+{
+    for (int lane = 0; lane < GANG_LANES; lane++) { spi_slave_write_cs(&gang_chips[lane].slave.bus, select); }
+}
+
+static unsigned long gang_half_periods;
+
+static void gang_delay(struct sspi const *bus)
+{
+    gang_half_periods++;
+}
+
+static uint32_t gang_read_miso(struct sspi_gang const *gang)
+{
+    uint32_t lanes = 0;
+    for (int lane = 0; lane < GANG_LANES; lane++)
+    {
+        if (spi_slave_read_miso(&gang_chips[lane].slave.bus) == SSPI_PIN_HIGH) { lanes |= (uint32_t)1 << lane; }
+    }
+    return lanes;
+}
+/*------------------------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------------------------*/
+/* SPI PSRAM emulation */
+/*------------------------------------------------------------------------------------------------*/
+#define PSRAM_PAGE_SIZE 1024
+#define PSRAM_SIZE 2048
+
+struct psram_chip
+{
+    struct spi_slave slave; /* Must be the first member */
+    uint8_t memory[PSRAM_SIZE];
+    uint8_t cmd;
+    uint32_t addr;
+};
+
+/* Bursts wrap within the page */
+static uint8_t *psram_chip_cell(struct psram_chip *chip, size_t offset)
+{
+    uint32_t const page = chip->addr - chip->addr % PSRAM_PAGE_SIZE;
+    return &chip->memory[page + (chip->addr + offset) % PSRAM_PAGE_SIZE];
+}
+
+static void psram_chip_byte(struct spi_slave *slave, uint8_t byte, size_t index)
+{
+    struct psram_chip *const chip = (struct psram_chip *)slave;
+    if (!index) { chip->cmd = byte; }
+    if (index >= 1 && index <= 3) { chip->addr = (chip->addr << 8 | byte) % PSRAM_SIZE; }
+    if (chip->cmd == SSPI_PSRAM_CMD_READ && index >= 3) { slave->out_byte = *psram_chip_cell(chip, index - 3); }
+    if (chip->cmd == SSPI_PSRAM_CMD_WRITE && index >= 4) { *psram_chip_cell(chip, index - 4) = byte; }
+}
+
+static void psram_chip_init(struct psram_chip *chip)
+{
+    *chip = (struct psram_chip){0};
+    spi_slave_init(&chip->slave, psram_chip_byte, NULL);
+}
+/*------------------------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------------------------*/
+/* Register device emulation: command is address | 0x80 for read, 0x40 for burst */
+/*------------------------------------------------------------------------------------------------*/
+struct reg_chip
+{
+    struct spi_slave slave; /* Must be the first member */
+    uint8_t regs[64];
+    uint8_t cmd;
+};
+
+static void reg_chip_byte(struct spi_slave *slave, uint8_t byte, size_t index)
+{
+    struct reg_chip *const chip = (struct reg_chip *)slave;
+    if (!index) { chip->cmd = byte; }
+
+    size_t const offset = (chip->cmd & 0x40) ? index : 0;
+    if (chip->cmd & 0x80) { slave->out_byte = chip->regs[((chip->cmd & 0x3F) + offset) % 64]; }
+}
+
+static void reg_chip_init(struct reg_chip *chip)
+{
+    *chip = (struct reg_chip){0};
+    spi_slave_init(&chip->slave, reg_chip_byte, NULL);
+}
+/*------------------------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------------------------*/
+/* Microwire EEPROM emulation (93C46 x16, CS active high) */
+/*------------------------------------------------------------------------------------------------*/
+#define MW_ADDR_BITS 6
+#define MW_WORDS 64
+#define MW_BUSY_POLLS 3
+
+struct mw_chip
+{
+    struct sspi bus; /* Must be the first member */
+    uint16_t memory[MW_WORDS];
+    bool sck, di, dout;
+    /* DO level driven after the output delay: it becomes visible on the next half period */
+    bool dout_next;
+    bool absent;
+    bool write_enabled;
+    int busy;
+    int bits;
+    uint32_t shift;
+    uint32_t op;
+    uint32_t addr;
+    int out_bit;
+    unsigned instructions;
+    unsigned writes;
+};
+
+static struct mw_chip *mw_chip_get(struct sspi const *bus)
+{
+    return (struct mw_chip *)bus;
+}
+
+static void mw_chip_write_sck(struct sspi const *bus, sspi_pin_state_t state)
+{
+    struct mw_chip *const chip = mw_chip_get(bus);
+    bool const rising = !chip->sck && state == SSPI_PIN_HIGH;
+    chip->sck = state == SSPI_PIN_HIGH;
+    if (!rising) { return; }
+
+    /* Leading zeros before the start bit are ignored */
+    if (!chip->bits && !chip->di) { return; }
+    chip->shift = chip->shift << 1 | (chip->di ? 1 : 0);
+    chip->bits++;
+
+    if (chip->bits == 3 + MW_ADDR_BITS)
+    {
+        chip->instructions++;
+        chip->op = (chip->shift >> MW_ADDR_BITS) & 0x3;
+        chip->addr = chip->shift & (MW_WORDS - 1);
+        chip->out_bit = 0;
+        if (chip->op == SSPI_MICROWIRE_OP_READ) { chip->dout_next = false; /* Dummy zero */ }
+        if (chip->op == SSPI_MICROWIRE_OP_EXTENDED)
+        {
+            uint32_t const ext = chip->addr >> (MW_ADDR_BITS - 2);
+            if (ext == SSPI_MICROWIRE_EXT_EWEN) { chip->write_enabled = true; }
+            if (ext == SSPI_MICROWIRE_EXT_EWDS) { chip->write_enabled = false; }
+        }
+    }
+    else if (chip->bits > 3 + MW_ADDR_BITS && chip->op == SSPI_MICROWIRE_OP_READ)
+    {
+        /* Sequential read: the address increments after every word */
+        chip->dout_next = (chip->memory[chip->addr] >> (15 - chip->out_bit)) & 1;
+        if (++chip->out_bit == 16)
+        {
+            chip->out_bit = 0;
+            chip->addr = (chip->addr + 1) % MW_WORDS;
+        }
+    }
+}
+
+static void mw_chip_write_mosi(struct sspi const *bus, sspi_pin_state_t state)
+{
+    mw_chip_get(bus)->di = state == SSPI_PIN_HIGH;
+}
+
+static sspi_pin_state_t mw_chip_read_miso(struct sspi const *bus)
+{
+    struct mw_chip *const chip = mw_chip_get(bus);
+
+    /* Floating DO is pulled up */
+    if (chip->absent) { return SSPI_PIN_HIGH; }
+    if (!chip->bits)
+    {
+        /* Ready/busy status */
+        if (chip->busy) { chip->busy--; return SSPI_PIN_LOW; }
+        return SSPI_PIN_HIGH;
+    }
+    return chip->dout ? SSPI_PIN_HIGH : SSPI_PIN_LOW;
+}
+
+static void mw_chip_delay(struct sspi const *bus)
+{
+    struct mw_chip *const chip = mw_chip_get(bus);
+    chip->dout = chip->dout_next;
+}
+
+static void mw_chip_write_cs(struct sspi const *bus, bool select)
+{
+    struct mw_chip *const chip = mw_chip_get(bus);
+
+    if (select)
+    {
+        /* DO is not driven until the read instruction */
+        chip->bits = 0;
+        chip->shift = 0;
+        chip->dout = true;
+        chip->dout_next = true;
+        return;
+    }
+
+    /* Write and erase start on deselect */
+    bool const enabled = chip->write_enabled && !chip->busy;
+    if (chip->op == SSPI_MICROWIRE_OP_WRITE && chip->bits == 3 + MW_ADDR_BITS + 16 && enabled)
+    {
+        chip->memory[chip->addr] = (uint16_t)chip->shift;
+        chip->writes++;
+        chip->busy = MW_BUSY_POLLS;
+    }
+    if (chip->op == SSPI_MICROWIRE_OP_ERASE && chip->bits == 3 + MW_ADDR_BITS && enabled)
+    {
+        chip->memory[chip->addr] = 0xFFFF;
+        chip->writes++;
+        chip->busy = MW_BUSY_POLLS;
+    }
+    chip->op = SSPI_MICROWIRE_OP_EXTENDED;
+    chip->bits = 0;
 }
 /*------------------------------------------------------------------------------------------------*/
 
@@ -148,6 +607,10 @@ void setUp(void)
     pin_sck = gpio_pin_new();
     pin_mosi = gpio_pin_new();
     pin_miso = gpio_pin_new();
+    pin_cs = gpio_pin_new();
+    ready_polls = "";
+    miso_reads = 0;
+    miso_vote_batches = 0;
 }
 
 void tearDown(void)
@@ -156,6 +619,7 @@ void tearDown(void)
     printf("\nSCK:  %s", gpio_pin_get_samples(&pin_sck));
     printf("\nMOSI: %s", gpio_pin_get_samples(&pin_mosi));
     printf("\nMISO: %s", gpio_pin_get_samples(&pin_miso));
+    printf("\nCS:   %s", gpio_pin_get_samples(&pin_cs));
     printf("\n\n");
 #endif
 }
@@ -433,6 +897,784 @@ static void test_mode_0_10bits(void)
     TEST_ASSERT_EQUAL_STRING("\\__/^^^^^^^\\_____/^\\__",
                              gpio_pin_get_samples(&pin_miso));
 }
+
+static void test_ready_per_word(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+        .word_size = 2,
+        .is_ready = is_ready,
+        .ready_policy = SSPI_READY_WORDS,
+    };
+
+    /* The slave is ready for the first word and busy for two polls before the second word */
+    ready_polls = "^__^";
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    uint8_t wr_buff[] = {0x03, 0x03};
+    TEST_ASSERT_TRUE(sspi_write(&sspi, wr_buff, sizeof(wr_buff)));
+    TEST_ASSERT_EQUAL_STRING("", ready_polls);
+
+    /* Wait until pin levels are established (for tests only) */
+    sspi.delay(&sspi); /* Sample pins */
+
+    TEST_ASSERT_EQUAL_STRING("\\_/\\/\\__/\\/\\",
+                             gpio_pin_get_samples(&pin_sck));
+    TEST_ASSERT_EQUAL_STRING("\\/^^^^^^^^^^",
+                             gpio_pin_get_samples(&pin_mosi));
+}
+
+static void test_ready_timeout(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+        .is_ready = is_ready,
+        .ready_policy = SSPI_READY_TRANSACTION,
+        .ready_timeout = 3,
+    };
+
+    ready_polls = "_____^";
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    uint8_t wr_buff[] = {0xFF};
+    TEST_ASSERT_FALSE(sspi_write(&sspi, wr_buff, sizeof(wr_buff)));
+
+    /* Nothing has been clocked out */
+    TEST_ASSERT_EQUAL_STRING("\\___", gpio_pin_get_samples(&pin_sck));
+
+    /* Slave without the ready line is always ready */
+    static struct sspi const no_handshake = {.delay = delay};
+    TEST_ASSERT_TRUE(sspi_wait_ready(&no_handshake));
+}
+
+static void test_acq_ring_buffer(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+        .write_cs = write_cs,
+        .word_size = 2,
+    };
+
+    static uint8_t const command[] = {0x02};
+    uint8_t samples[3];
+    uint32_t timestamps[3];
+    struct sspi_acq acq = {
+        .bus = &sspi,
+        .command = command,
+        .command_size = sizeof(command),
+        .sample_size = 1,
+        .samples = samples,
+        .timestamps = timestamps,
+        .capacity = 3,
+    };
+
+    /* Sensor answers 0x01, 0x02 and 0x03 on three DRDY events */
+    gpio_pin_set_in(&pin_miso, "\\______/\\_____/\\_______/^^^^");
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    TEST_ASSERT_TRUE(sspi_acq_trigger(&acq, 100));
+    sspi.delay(&sspi); /* Sample pins */
+    TEST_ASSERT_TRUE(sspi_acq_trigger(&acq, 200));
+    sspi.delay(&sspi); /* Sample pins */
+    /* Ring buffer is full: the transaction runs, but the sample is dropped */
+    TEST_ASSERT_FALSE(sspi_acq_trigger(&acq, 300));
+    TEST_ASSERT_EQUAL_size_t(1, atomic_load(&acq.overruns));
+    TEST_ASSERT_EQUAL_size_t(2, sspi_acq_count(&acq));
+
+    uint8_t sample;
+    uint32_t timestamp;
+    TEST_ASSERT_TRUE(sspi_acq_pop(&acq, &sample, &timestamp));
+    TEST_ASSERT_EQUAL_UINT8(0x01, sample);
+    TEST_ASSERT_EQUAL_UINT32(100, timestamp);
+    TEST_ASSERT_TRUE(sspi_acq_pop(&acq, &sample, &timestamp));
+    TEST_ASSERT_EQUAL_UINT8(0x02, sample);
+    TEST_ASSERT_EQUAL_UINT32(200, timestamp);
+    TEST_ASSERT_FALSE(sspi_acq_pop(&acq, &sample, &timestamp));
+
+    /* Wait until pin levels are established (for tests only) */
+    sspi.delay(&sspi); /* Sample pins */
+
+    TEST_ASSERT_EQUAL_STRING("^\\_______/\\_______/\\_______/",
+                             gpio_pin_get_samples(&pin_cs));
+}
+
+static void test_flash_program_compressed(void)
+{
+    /* "ABCABCABCABCABCABCABCABC-sspi-sspi-sspi-sspi-ABCABCABC" compressed with -w 8 -l 4 */
+    static uint8_t const compressed[] = {0xA0, 0xD0, 0xA8, 0x60, 0x2F, 0x01, 0x24, 0xB6,
+                                         0xE7, 0x73, 0xB8, 0x5A, 0x40, 0x9E, 0x1D, 0x80};
+    static char const image[] = "ABCABCABCABCABCABCABCABC-sspi-sspi-sspi-sspi-ABCABCABC";
+
+    static struct flash_chip chip;
+    flash_chip_init(&chip);
+    struct sspi_flash const flash = {
+        .bus = &chip.slave.bus,
+        .page_size = FLASH_PAGE_SIZE,
+        .sector_size = FLASH_SECTOR_SIZE,
+    };
+
+    uint8_t window[1 << 8];
+    struct sspi_heatshrink hs = {
+        .input = compressed,
+        .input_size = sizeof(compressed),
+        .window = window,
+        .window_bits = 8,
+        .lookahead_bits = 4,
+    };
+    sspi_heatshrink_reset(&hs);
+
+    /* Start in the middle of a page */
+    size_t size = 0;
+    TEST_ASSERT_TRUE(sspi_flash_program_stream(&flash, 10, sspi_heatshrink_read, &hs, &size));
+    TEST_ASSERT_EQUAL_size_t(sizeof(image) - 1, size);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image, chip.memory + 10, sizeof(image) - 1);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, chip.memory[9]);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, chip.memory[10 + sizeof(image) - 1]);
+
+    /* Pages 0-3 are programmed once each */
+    TEST_ASSERT_EQUAL_UINT32(4, chip.programs);
+
+    uint8_t read_back[sizeof(image) - 1];
+    TEST_ASSERT_TRUE(sspi_flash_read(&flash, 10, read_back, sizeof(read_back)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image, read_back, sizeof(read_back));
+}
+
+static void test_flash_differential_update(void)
+{
+    static struct flash_chip chip;
+    flash_chip_init(&chip);
+    struct sspi_flash const flash = {
+        .bus = &chip.slave.bus,
+        .page_size = FLASH_PAGE_SIZE,
+        .sector_size = FLASH_SECTOR_SIZE,
+    };
+
+    /* The last page of the image stays erased */
+    uint8_t image[FLASH_SIZE - FLASH_PAGE_SIZE];
+    for (size_t i = 0; i < sizeof(image); i++) { image[i] = (uint8_t)(i * 7); }
+    TEST_ASSERT_TRUE(sspi_flash_program(&flash, 0, image, sizeof(image)));
+
+    size_t updated = 0;
+    TEST_ASSERT_TRUE(sspi_flash_update(&flash, 0, image, sizeof(image), &updated));
+    TEST_ASSERT_EQUAL_size_t(0, updated);
+    TEST_ASSERT_EQUAL_UINT32(0, chip.erases);
+
+    /* Change one byte in sector 1 and clear the whole page in sector 2 */
+    image[FLASH_SECTOR_SIZE + 5] ^= 0x55;
+    memset(image + 2 * FLASH_SECTOR_SIZE, 0xFF, FLASH_PAGE_SIZE);
+    chip.programs = 0;
+
+    TEST_ASSERT_TRUE(sspi_flash_update(&flash, 0, image, sizeof(image), &updated));
+    TEST_ASSERT_EQUAL_size_t(2, updated);
+    TEST_ASSERT_EQUAL_UINT32(2, chip.erases);
+    /* 4 pages of sector 1 and 3 non-empty pages of sector 2 */
+    TEST_ASSERT_EQUAL_UINT32(7, chip.programs);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image, chip.memory, sizeof(image));
+
+    uint32_t crc;
+    TEST_ASSERT_TRUE(sspi_flash_crc32(&flash, 0, sizeof(image), &crc));
+    TEST_ASSERT_EQUAL_HEX32(sspi_flash_crc32_update(0, image, sizeof(image)), crc);
+
+    /* Data past the end of the image is erased even when the image part matches */
+    chip.memory[FLASH_SIZE - 1] = 0x00;
+    TEST_ASSERT_TRUE(sspi_flash_update(&flash, 0, image, sizeof(image), &updated));
+    TEST_ASSERT_EQUAL_size_t(1, updated);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, chip.memory[FLASH_SIZE - 1]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image, chip.memory, sizeof(image));
+}
+
+static void test_flash_gang_programming(void)
+{
+    static struct sspi const bus = {
+        .write_sck = gang_write_sck,
+        .write_mosi = gang_write_mosi,
+        .delay = gang_delay,
+        .write_cs = gang_write_cs,
+    };
+    static struct sspi_flash const flash = {
+        .bus = &bus,
+        .page_size = FLASH_PAGE_SIZE,
+        .sector_size = FLASH_SECTOR_SIZE,
+        .busy_timeout = 10,
+    };
+    static struct sspi_gang const gang = {
+        .flash = &flash,
+        .read_miso = gang_read_miso,
+        .lanes = GANG_LANES,
+    };
+
+    for (int lane = 0; lane < GANG_LANES; lane++)
+    {
+        flash_chip_init(&gang_chips[lane]);
+        /* Old data must be erased */
+        memset(gang_chips[lane].memory, 0x5A, sizeof(gang_chips[lane].memory));
+    }
+    /* The chip on lane 1 ignores write enable command */
+    gang_chips[1].write_protected = true;
+
+    uint8_t image[FLASH_SECTOR_SIZE + FLASH_PAGE_SIZE + 3];
+    for (size_t i = 0; i < sizeof(image); i++) { image[i] = (uint8_t)(i * 13 + 1); }
+
+    TEST_ASSERT_EQUAL_HEX32(0x02, sspi_gang_write_image(&gang, FLASH_SECTOR_SIZE, image, sizeof(image)));
+
+    for (int lane = 0; lane < GANG_LANES; lane += 2)
+    {
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(image, gang_chips[lane].memory + FLASH_SECTOR_SIZE, sizeof(image));
+        TEST_ASSERT_EQUAL_UINT8(0x5A, gang_chips[lane].memory[0]);
+        TEST_ASSERT_EQUAL_UINT32(2, gang_chips[lane].erases);
+        TEST_ASSERT_EQUAL_UINT32(6, gang_chips[lane].programs);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, gang_chips[1].programs);
+}
+
+/* Empty socket: its status reads 0xFF forever */
+static void test_flash_gang_absent_chip(void)
+{
+    static struct sspi const bus = {
+        .write_sck = gang_write_sck,
+        .write_mosi = gang_write_mosi,
+        .delay = gang_delay,
+        .write_cs = gang_write_cs,
+    };
+    static struct sspi_flash const flash = {
+        .bus = &bus,
+        .page_size = FLASH_PAGE_SIZE,
+        .sector_size = FLASH_SECTOR_SIZE,
+        .busy_timeout = 10,
+    };
+    static struct sspi_gang const gang = {
+        .flash = &flash,
+        .read_miso = gang_read_miso,
+        .lanes = GANG_LANES,
+    };
+    uint8_t image[2 * FLASH_PAGE_SIZE];
+    for (size_t i = 0; i < sizeof(image); i++) { image[i] = (uint8_t)(i * 13 + 1); }
+
+    /* Reference run with all chips in place */
+    for (int lane = 0; lane < GANG_LANES; lane++) { flash_chip_init(&gang_chips[lane]); }
+    gang_half_periods = 0;
+    TEST_ASSERT_EQUAL_HEX32(0x00, sspi_gang_write_image(&gang, 0, image, sizeof(image)));
+    unsigned long const reference = gang_half_periods;
+
+    for (int lane = 0; lane < GANG_LANES; lane++) { flash_chip_init(&gang_chips[lane]); }
+    gang_chips[2].slave.absent = true;
+    gang_half_periods = 0;
+    TEST_ASSERT_EQUAL_HEX32(0x04, sspi_gang_write_image(&gang, 0, image, sizeof(image)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image, gang_chips[0].memory, sizeof(image));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image, gang_chips[1].memory, sizeof(image));
+
+    /* The lane times out once during erase and is dropped from the program waits */
+    TEST_ASSERT_EQUAL_UINT32(reference + (flash.busy_timeout - (FLASH_BUSY_POLLS + 1)) * 16, gang_half_periods);
+
+    /* Operations without a timeout are refused before any command is sent */
+    static struct sspi_flash const no_timeout = {
+        .bus = &bus,
+        .page_size = FLASH_PAGE_SIZE,
+        .sector_size = FLASH_SECTOR_SIZE,
+    };
+    static struct sspi_gang const gang_no_timeout = {
+        .flash = &no_timeout,
+        .read_miso = gang_read_miso,
+        .lanes = GANG_LANES,
+    };
+    for (int lane = 0; lane < GANG_LANES; lane++) { flash_chip_init(&gang_chips[lane]); }
+    gang_half_periods = 0;
+    TEST_ASSERT_EQUAL_HEX32(0x03, sspi_gang_wait(&gang_no_timeout, 0x03));
+    TEST_ASSERT_EQUAL_HEX32(0x05, sspi_gang_erase_sector(&gang_no_timeout, 0, 0x05));
+    TEST_ASSERT_EQUAL_HEX32(0x07, sspi_gang_program(&gang_no_timeout, 0, image, sizeof(image), 0x07));
+    TEST_ASSERT_EQUAL_HEX32(0x07, sspi_gang_write_image(&gang_no_timeout, 0, image, sizeof(image)));
+    TEST_ASSERT_EQUAL_UINT32(0, gang_half_periods);
+    for (int lane = 0; lane < GANG_LANES; lane++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(0, gang_chips[lane].erases);
+        TEST_ASSERT_EQUAL_UINT32(0, gang_chips[lane].programs);
+    }
+}
+
+static void test_ssi_encoder(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+    };
+    struct sspi_ssi enc = {
+        .bus = &sspi,
+        .position_bits = 4,
+        .status_bits = 1,
+        .error_mask = 0x01,
+        .gray = true,
+        .monoflop = 4,
+    };
+
+    /* Gray codes 0010 (3), 1000 (15) and 0110 (4) with the error bit */
+    gpio_pin_set_in(&pin_miso, "^\\/\\/^^\\/\\/^^^^^^\\/\\/\\/\\/^^^^\\/^^^^\\/^^^^^^^");
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    TEST_ASSERT_TRUE(sspi_ssi_read(&enc));
+    TEST_ASSERT_EQUAL_UINT32(3, enc.raw);
+    TEST_ASSERT_EQUAL_INT64(3, enc.position);
+
+    /* Counter overflows backwards */
+    TEST_ASSERT_TRUE(sspi_ssi_read(&enc));
+    TEST_ASSERT_EQUAL_UINT32(15, enc.raw);
+    TEST_ASSERT_EQUAL_INT64(-1, enc.position);
+
+    TEST_ASSERT_FALSE(sspi_ssi_read(&enc));
+    TEST_ASSERT_EQUAL_UINT32(0x01, enc.status);
+    TEST_ASSERT_EQUAL_INT64(-1, enc.position);
+
+    /* Wait until pin levels are established (for tests only) */
+    sspi.delay(&sspi); /* Sample pins */
+
+    /* Clock bursts are separated by the monoflop time */
+    TEST_ASSERT_EQUAL_STRING("\\_/\\/\\/\\/\\/\\____/\\/\\/\\/\\/\\____/\\/\\/\\/\\/\\____",
+                             gpio_pin_get_samples(&pin_sck));
+}
+
+static void test_cs_per_word(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+        .write_cs = write_cs,
+        .word_size = 2,
+        .word_gap = 2,
+        .cs_per_word = true,
+    };
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    uint8_t wr_buff[] = {0x03, 0x01};
+    TEST_ASSERT_TRUE(sspi_write(&sspi, wr_buff, sizeof(wr_buff)));
+
+    /* Wait until pin levels are established (for tests only) */
+    sspi.delay(&sspi); /* Sample pins */
+
+    /* CS is held for a half period after the last edge and stays high for 'word_gap' */
+    TEST_ASSERT_EQUAL_STRING("\\_/\\/\\___/\\/\\_",
+                             gpio_pin_get_samples(&pin_sck));
+    TEST_ASSERT_EQUAL_STRING("\\/^^^^^^\\_/^^^",
+                             gpio_pin_get_samples(&pin_mosi));
+    TEST_ASSERT_EQUAL_STRING("^\\____/^\\____/",
+                             gpio_pin_get_samples(&pin_cs));
+}
+
+/* The same transfer as in test_mode_0_msb_8bit with a glitch on every third MISO read */
+static void test_miso_majority_voting(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso_glitchy,
+        .delay = delay,
+        .miso_samples = 3,
+    };
+
+    gpio_pin_set_in(&pin_miso, "___/^^^^^^^\\_____/^\\_/^\\___/^\\_/^");
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    uint8_t rd_buff[] = {0x00, 0x00};
+    uint8_t wr_buff[] = {0x87, 0x5A};
+    sspi_read_write(&sspi, rd_buff, wr_buff, sizeof(wr_buff));
+    uint8_t rd_exp[] = {0x78, 0xA5};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(rd_exp, rd_buff, sizeof(rd_buff));
+    TEST_ASSERT_EQUAL_INT(3 * 16, miso_reads);
+}
+
+/* Samples of a bit are taken with one batched port read instead of a callback per sample */
+static void test_miso_majority_voting_batched(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso_glitchy,
+        .delay = delay,
+        .miso_samples = 5,
+        .read_miso_votes = read_miso_votes_glitchy,
+    };
+
+    gpio_pin_set_in(&pin_miso, "___/^^^^^^^\\_____/^\\_/^\\___/^\\_/^");
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    uint8_t rd_buff[] = {0x00, 0x00};
+    uint8_t wr_buff[] = {0x87, 0x5A};
+    sspi_read_write(&sspi, rd_buff, wr_buff, sizeof(wr_buff));
+    uint8_t rd_exp[] = {0x78, 0xA5};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(rd_exp, rd_buff, sizeof(rd_buff));
+    TEST_ASSERT_EQUAL_INT(16, miso_vote_batches);
+    TEST_ASSERT_EQUAL_INT(0, miso_reads);
+}
+
+/* The waveform matches the output of sspi_write() in mode 0 (see test_mode_0_msb_8bit).
+ * The last bit is 1 to check that MOSI is returned low at the end.
+ * */
+static void test_wave_mode_0_msb(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+    };
+    static uint8_t const wave[] = {
+        SSPI_WAVE_BYTE(0, 0, 0, 0x87),
+        SSPI_WAVE_BYTE(0, 0, 0, 0x5B),
+    };
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    sspi_wave_play(&sspi, wave, sizeof(wave));
+
+    /* The last trailing edge and the MOSI reset are played without a table entry */
+    sspi.delay(&sspi); /* Sample pins */
+
+    TEST_ASSERT_EQUAL_STRING("\\_/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\",
+                             gpio_pin_get_samples(&pin_sck));
+    TEST_ASSERT_EQUAL_STRING("\\/^\\_______/^^^^^\\_/^\\_/^^^\\_/^^^\\",
+                             gpio_pin_get_samples(&pin_mosi));
+}
+
+/* The waveform matches the output of sspi_write() in mode 1 (see test_mode_1_msb_8bit) */
+static void test_wave_mode_1_msb(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+        .cpha_1 = true,
+    };
+    static uint8_t const wave[] = {
+        SSPI_WAVE_IDLE(0),
+        SSPI_WAVE_BYTE(0, 1, 0, 0x87),
+        SSPI_WAVE_BYTE(0, 1, 0, 0x5A),
+    };
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    sspi_wave_play(&sspi, wave, sizeof(wave));
+
+    TEST_ASSERT_EQUAL_STRING("\\_/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\",
+                             gpio_pin_get_samples(&pin_sck));
+    TEST_ASSERT_EQUAL_STRING("\\_/^\\_______/^^^^^\\_/^\\_/^^^\\_/^\\_",
+                             gpio_pin_get_samples(&pin_mosi));
+}
+
+static void test_pool_transfers(void)
+{
+    SSPI_POOL_DEFINE(xfer_pool, sizeof(struct sspi_transfer), 2);
+    SSPI_POOL_DEFINE(payload_pool, 8, 2);
+
+    static struct flash_chip chip;
+    flash_chip_init(&chip);
+    memcpy(chip.memory + 0x20, "payload!", 8);
+
+    /* Command and data phases of one read transaction */
+    static uint8_t const command[] = {SSPI_FLASH_CMD_READ, 0x00, 0x00, 0x20};
+    struct sspi_transfer *data = sspi_pool_alloc(&xfer_pool);
+    struct sspi_transfer *cmd = sspi_pool_alloc(&xfer_pool);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_NOT_NULL(cmd);
+    TEST_ASSERT_NULL(sspi_pool_alloc(&xfer_pool));
+
+    *data = (struct sspi_transfer){.read_buff = sspi_pool_alloc(&payload_pool), .size = 8};
+    *cmd = (struct sspi_transfer){.write_buff = command, .size = sizeof(command), .next = data};
+    TEST_ASSERT_TRUE(sspi_transfer(&chip.slave.bus, cmd));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("payload!", data->read_buff, 8);
+
+    /* Freed block is reused */
+    sspi_pool_free(&xfer_pool, cmd);
+    TEST_ASSERT_EQUAL_PTR(cmd, sspi_pool_alloc(&xfer_pool));
+
+    /* Bulk reset after the batch keeps the statistics */
+    sspi_pool_reset(&xfer_pool);
+    TEST_ASSERT_EQUAL_size_t(0, xfer_pool.used);
+    TEST_ASSERT_EQUAL_size_t(2, xfer_pool.high_water);
+    TEST_ASSERT_EQUAL_PTR(data, sspi_pool_alloc(&xfer_pool));
+    TEST_ASSERT_EQUAL_size_t(1, payload_pool.high_water);
+}
+
+/* Single rate command followed by a double data rate data phase */
+static void test_dtr_transfer(void)
+{
+    static struct sspi const sspi = {
+        .write_sck = write_sck,
+        .write_mosi = write_mosi,
+        .read_miso = read_miso,
+        .delay = delay,
+        .write_cs = write_cs,
+    };
+
+    gpio_pin_set_in(&pin_miso, "^^^^^^^^^^^^^^^^^\\_/^^^\\_/");
+
+    /* Set pins to default state */
+    sspi_reset(&sspi);
+    sspi.delay(&sspi); /* Sample pins */
+
+    static uint8_t const command[] = {0x0D};
+    uint8_t data = 0x00;
+    struct sspi_transfer const data_phase = {.read_buff = &data, .size = 1, .dtr = true};
+    struct sspi_transfer const command_phase = {.write_buff = command, .size = 1, .next = &data_phase};
+    TEST_ASSERT_TRUE(sspi_transfer(&sspi, &command_phase));
+    TEST_ASSERT_EQUAL_HEX8(0x3C, data);
+
+    /* Wait until pin levels are established (for tests only) */
+    sspi.delay(&sspi); /* Sample pins */
+
+    /* 8 bits of the command take 8 clocks, 8 bits of data take 4 clocks */
+    TEST_ASSERT_EQUAL_STRING("\\_/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\/\\",
+                             gpio_pin_get_samples(&pin_sck));
+    TEST_ASSERT_EQUAL_STRING("^\\_______________________/",
+                             gpio_pin_get_samples(&pin_cs));
+}
+
+/* Two chips on separate buses joined with a stripe unit of one page */
+static void test_flash_striping(void)
+{
+    static struct flash_chip chips[2];
+    static struct sspi_flash flashes[2];
+    for (int i = 0; i < 2; i++)
+    {
+        flash_chip_init(&chips[i]);
+        memset(chips[i].memory, 0x5A, sizeof(chips[i].memory));
+        flashes[i] = (struct sspi_flash){
+            .bus = &chips[i].slave.bus,
+            .page_size = FLASH_PAGE_SIZE,
+            .sector_size = FLASH_SECTOR_SIZE,
+        };
+    }
+    struct sspi_stripe const stripe = {.chips = flashes, .count = 2, .stripe_size = FLASH_PAGE_SIZE};
+
+    uint8_t data[100];
+    for (size_t i = 0; i < sizeof(data); i++) { data[i] = (uint8_t)(i * 7 + 1); }
+
+    TEST_ASSERT_TRUE(sspi_stripe_erase(&stripe, 0, 2 * FLASH_SECTOR_SIZE));
+    TEST_ASSERT_TRUE(sspi_stripe_program(&stripe, 8, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT32(1, chips[0].erases);
+    TEST_ASSERT_EQUAL_UINT32(1, chips[1].erases);
+    TEST_ASSERT_EQUAL_UINT32(4, chips[0].programs);
+    TEST_ASSERT_EQUAL_UINT32(3, chips[1].programs);
+
+    /* Stripe units alternate between the chips */
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chips[0].memory + 8, 8);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 8, chips[1].memory, 16);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 24, chips[0].memory + 16, 16);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 88, chips[0].memory + 48, 12);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, chips[0].memory[60]);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, chips[0].memory[FLASH_SECTOR_SIZE]);
+
+    uint8_t buff[sizeof(data)];
+    TEST_ASSERT_TRUE(sspi_stripe_read(&stripe, 8, buff, sizeof(buff)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, buff, sizeof(data));
+
+    /* Both buses are clocked together: 96 bytes take the time of 4 command and 48 data bytes */
+    chips[0].slave.half_periods = 0;
+    chips[1].slave.half_periods = 0;
+    TEST_ASSERT_TRUE(sspi_stripe_read(&stripe, 0, buff, 96));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, buff + 8, 88);
+    TEST_ASSERT_EQUAL_UINT32((4 + 48) * 16, chips[0].slave.half_periods);
+    TEST_ASSERT_EQUAL_UINT32(0, chips[1].slave.half_periods);
+
+    /* Range inside one stripe unit erases only the chip holding it */
+    TEST_ASSERT_TRUE(sspi_stripe_erase(&stripe, 40, 4));
+    TEST_ASSERT_EQUAL_UINT32(2, chips[0].erases);
+    TEST_ASSERT_EQUAL_UINT32(1, chips[1].erases);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 8, chips[1].memory, 16);
+}
+
+static void test_psram_cache(void)
+{
+    static struct psram_chip chip;
+    psram_chip_init(&chip);
+    for (size_t i = 0; i < PSRAM_SIZE; i++) { chip.memory[i] = (uint8_t)i; }
+
+    static struct sspi_psram psram = {
+        .bus = &chip.slave.bus,
+        .size = PSRAM_SIZE,
+        .page_size = PSRAM_PAGE_SIZE,
+        .granule_size = 128,
+    };
+    sspi_psram_init(&psram);
+
+    /* First fit over the granule bitmap */
+    uint32_t const a = sspi_psram_alloc(&psram, 200);
+    TEST_ASSERT_EQUAL_UINT32(0, a);
+    TEST_ASSERT_EQUAL_UINT32(256, sspi_psram_alloc(&psram, 128));
+    TEST_ASSERT_EQUAL_UINT32(SSPI_PSRAM_NULL, sspi_psram_alloc(&psram, PSRAM_SIZE));
+    sspi_psram_free(&psram, a);
+    TEST_ASSERT_EQUAL_UINT32(0, sspi_psram_alloc(&psram, 100));
+    TEST_ASSERT_EQUAL_UINT32(384, sspi_psram_alloc(&psram, 200));
+
+    /* Partial line write fills the line, then the modified line serves reads */
+    uint8_t buff[4];
+    TEST_ASSERT_TRUE(sspi_psram_write(&psram, 130, (uint8_t const *)"abc", 3));
+    TEST_ASSERT_EQUAL_UINT32(1, chip.slave.transactions);
+    TEST_ASSERT_EQUAL_HEX8(130, chip.memory[130]);
+    TEST_ASSERT_TRUE(sspi_psram_read(&psram, 129, buff, sizeof(buff)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("\x81" "abc", buff, sizeof(buff));
+    TEST_ASSERT_EQUAL_UINT32(1, psram.hits);
+    TEST_ASSERT_EQUAL_UINT32(1, psram.misses);
+
+    /* Whole line write needs no fill */
+    uint8_t line[SSPI_PSRAM_LINE_SIZE];
+    memset(line, 0xA5, sizeof(line));
+    TEST_ASSERT_TRUE(sspi_psram_write(&psram, 256, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_UINT32(1, chip.slave.transactions);
+
+    /* Least recently used dirty line is written back on eviction */
+    TEST_ASSERT_TRUE(sspi_psram_read(&psram, 512, buff, 1));
+    TEST_ASSERT_TRUE(sspi_psram_read(&psram, 544, buff, 1));
+    TEST_ASSERT_EQUAL_UINT32(3, chip.slave.transactions);
+    TEST_ASSERT_TRUE(sspi_psram_read(&psram, 600, buff, 1));
+    TEST_ASSERT_EQUAL_HEX8(600 & 0xFF, buff[0]);
+    TEST_ASSERT_EQUAL_UINT32(5, chip.slave.transactions);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("abc", chip.memory + 130, 3);
+
+    TEST_ASSERT_TRUE(sspi_psram_flush(&psram));
+    TEST_ASSERT_EQUAL_UINT32(6, chip.slave.transactions);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(line, chip.memory + 256, sizeof(line));
+    TEST_ASSERT_TRUE(sspi_psram_flush(&psram));
+    TEST_ASSERT_EQUAL_UINT32(6, chip.slave.transactions);
+}
+
+/* Register 0x04 is a FIFO: reading it pops data */
+static bool reg_chip_is_read_sensitive(struct sspi_regs const *regs, uint8_t addr)
+{
+    return addr == 0x04;
+}
+
+static void test_regs_read_planner(void)
+{
+    static struct reg_chip chip;
+    reg_chip_init(&chip);
+    for (size_t i = 0; i < sizeof(chip.regs); i++) { chip.regs[i] = (uint8_t)(0xC0 + i); }
+
+    /* Transaction costs as much as three data bytes */
+    struct sspi_regs regs = {
+        .bus = &chip.slave.bus,
+        .read_flag = 0x80,
+        .burst_flag = 0x40,
+        .transaction_cost = 48,
+        .byte_cost = 16,
+    };
+    static uint8_t const addrs[] = {0x00, 0x02, 0x05, 0x20};
+    uint8_t values[4];
+    size_t transactions;
+
+    /* 0x00-0x05 are read as one burst with 3 dropped bytes, 0x20 alone */
+    TEST_ASSERT_EQUAL_UINT32(2 * 48 + 7 * 16, sspi_regs_cost(&regs, addrs, 4, &transactions));
+    TEST_ASSERT_EQUAL_size_t(2, transactions);
+    TEST_ASSERT_TRUE(sspi_regs_read(&regs, addrs, values, 4));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("\xC0\xC2\xC5\xE0", values, 4);
+    TEST_ASSERT_EQUAL_UINT32(2, chip.slave.transactions);
+    TEST_ASSERT_EQUAL_UINT32(2 + 7, chip.slave.bytes);
+
+    /* Free transactions: every register is read separately */
+    regs.transaction_cost = 0;
+    TEST_ASSERT_EQUAL_UINT32(4 * 16, sspi_regs_cost(&regs, addrs, 4, &transactions));
+    TEST_ASSERT_EQUAL_size_t(4, transactions);
+    memset(values, 0, sizeof(values));
+    TEST_ASSERT_TRUE(sspi_regs_read(&regs, addrs, values, 4));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("\xC0\xC2\xC5\xE0", values, 4);
+    TEST_ASSERT_EQUAL_UINT32(2 + 4, chip.slave.transactions);
+
+    /* FIFO register is never read as a gap byte: 0x00-0x02, 0x05 and 0x20 */
+    regs.transaction_cost = 48;
+    regs.is_read_sensitive = reg_chip_is_read_sensitive;
+    TEST_ASSERT_EQUAL_UINT32(3 * 48 + 5 * 16, sspi_regs_cost(&regs, addrs, 4, &transactions));
+    TEST_ASSERT_EQUAL_size_t(3, transactions);
+
+    /* Bursts are limited by the buffer size */
+    regs.transaction_cost = 1000;
+    regs.is_read_sensitive = NULL;
+    sspi_regs_cost(&regs, addrs, 4, &transactions);
+    TEST_ASSERT_EQUAL_size_t(2, transactions);
+    memset(values, 0, sizeof(values));
+    TEST_ASSERT_TRUE(sspi_regs_read(&regs, addrs, values, 4));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("\xC0\xC2\xC5\xE0", values, 4);
+}
+
+static void test_microwire_eeprom(void)
+{
+    static struct mw_chip chip = {
+        .bus = {
+            .write_sck = mw_chip_write_sck,
+            .write_mosi = mw_chip_write_mosi,
+            .read_miso = mw_chip_read_miso,
+            .delay = mw_chip_delay,
+            .write_cs = mw_chip_write_cs,
+        },
+    };
+    for (size_t i = 0; i < MW_WORDS; i++) { chip.memory[i] = (uint16_t)(i * 0x0101 ^ 0x1234); }
+
+    struct sspi_microwire const mw = {.bus = &chip.bus, .addr_bits = MW_ADDR_BITS, .word_bits = 16, .busy_timeout = 10};
+
+    /* Whole array in one instruction, wrapping around from the middle */
+    uint16_t words[MW_WORDS];
+    TEST_ASSERT_TRUE(sspi_microwire_read(&mw, MW_WORDS / 2, words, MW_WORDS));
+    TEST_ASSERT_EQUAL_UINT32(1, chip.instructions);
+    for (size_t i = 0; i < MW_WORDS; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX16(chip.memory[(i + MW_WORDS / 2) % MW_WORDS], words[i]);
+    }
+
+    /* Writes are ignored until enabled */
+    TEST_ASSERT_TRUE(sspi_microwire_write(&mw, 5, 0xBEEF));
+    TEST_ASSERT_EQUAL_UINT32(0, chip.writes);
+    sspi_microwire_write_enable(&mw, true);
+    TEST_ASSERT_TRUE(sspi_microwire_write(&mw, 5, 0xBEEF));
+    TEST_ASSERT_TRUE(sspi_microwire_erase(&mw, 6));
+    TEST_ASSERT_EQUAL_UINT32(2, chip.writes);
+    TEST_ASSERT_EQUAL_HEX16(0xBEEF, chip.memory[5]);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, chip.memory[6]);
+    sspi_microwire_write_enable(&mw, false);
+    TEST_ASSERT_FALSE(chip.write_enabled);
+
+    TEST_ASSERT_TRUE(sspi_microwire_read(&mw, 5, words, 2));
+    TEST_ASSERT_EQUAL_HEX16(0xBEEF, words[0]);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, words[1]);
+
+    /* Missing device: DO stays high, no dummy zero */
+    chip.absent = true;
+    TEST_ASSERT_FALSE(sspi_microwire_read(&mw, 0, words, 1));
+}
 /*------------------------------------------------------------------------------------------------*/
 
 /*------------------------------------------------------------------------------------------------*/
@@ -447,6 +1689,25 @@ int main(void)
     RUN_TEST(test_mode_1_msb_8bit);
     RUN_TEST(test_mode_3_msb_8bit);
     RUN_TEST(test_mode_0_10bits);
+    RUN_TEST(test_ready_per_word);
+    RUN_TEST(test_ready_timeout);
+    RUN_TEST(test_acq_ring_buffer);
+    RUN_TEST(test_flash_program_compressed);
+    RUN_TEST(test_flash_differential_update);
+    RUN_TEST(test_flash_gang_programming);
+    RUN_TEST(test_flash_gang_absent_chip);
+    RUN_TEST(test_ssi_encoder);
+    RUN_TEST(test_miso_majority_voting);
+    RUN_TEST(test_miso_majority_voting_batched);
+    RUN_TEST(test_cs_per_word);
+    RUN_TEST(test_wave_mode_0_msb);
+    RUN_TEST(test_wave_mode_1_msb);
+    RUN_TEST(test_pool_transfers);
+    RUN_TEST(test_dtr_transfer);
+    RUN_TEST(test_flash_striping);
+    RUN_TEST(test_psram_cache);
+    RUN_TEST(test_regs_read_planner);
+    RUN_TEST(test_microwire_eeprom);
     return UNITY_END();
 }
 /*------------------------------------------------------------------------------------------------*/
\ No newline at end of file